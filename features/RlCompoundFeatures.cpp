@@ -23,7 +23,7 @@ void RlCompoundFeatures::Initialise()
         m_featureSets[i]->EnsureInitialised();
 }
 
-void RlCompoundFeatures::CreateChildTrackers(
+void RlCompoundFeatures::CreateChildTrackers(GoBoard& board,
     map<RlBinaryFeatures*, RlTracker*>& trackermap)
 {
     for (int i = 0; i < ssize(m_featureSets); ++i)
@@ -31,7 +31,8 @@ void RlCompoundFeatures::CreateChildTrackers(
         RlBinaryFeatures* child = m_featureSets[i];
 		if (!trackermap[child])
 		{
-			RlTracker* childtracker = child->CreateTracker(trackermap);
+			RlTracker* childtracker = 
+                child->CreateTracker(board, trackermap);
             trackermap[child] = childtracker;
 		}
     }
@@ -113,6 +114,16 @@ void RlCompoundTracker::Execute(SgMove move, SgBlackWhite colour,
         m_trackers[i]->Execute(move, colour, execute, store);
 }
 
+bool RlCompoundTracker::ExecuteHypothetical(SgMove move, 
+    SgBlackWhite colour)
+{
+    RlTracker::ExecuteHypothetical(move, colour);
+    for (int i = 0; i < ssize(m_trackers); ++i)
+        if (!m_trackers[i]->ExecuteHypothetical(move, colour))
+            return false;
+    return true;
+}
+
 void RlCompoundTracker::Undo()
 {
     RlTracker::Undo();
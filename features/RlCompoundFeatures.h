@@ -40,7 +40,7 @@ protected:
     /** Create trackers for all children and store in the trackermap.
         Won't create trackers for classes already in the trackermap.
         To be called by child classes during CreateTracker. */
-    void CreateChildTrackers(
+    void CreateChildTrackers(GoBoard& board,
         std::map<RlBinaryFeatures*, RlTracker*>& trackermap);
 
     std::vector<RlBinaryFeatures*> m_featureSets;
@@ -74,6 +74,9 @@ public:
 
     /** Incremental undo */
     virtual void Undo();
+
+    /** Changes for a non-capturing move, without updating board */
+    virtual bool ExecuteHypothetical(SgMove move, SgBlackWhite colour);
     
     /** Update dirty moves */
     virtual void UpdateDirty(SgMove move, SgBlackWhite colour,
@@ -122,15 +122,15 @@ void RlLocalShapeFusion::Convert(const RlWeightSet* allweights,
         featureindex < fusedweights->GetNumFeatures(); 
         featureindex++)
     {
-        RlWeight& w = fusedweights->Get(featureindex);
-        w.Weight() = 0;
+        RlWeight w = fusedweights->Get(featureindex);
+        w.SetWeight(0);
         for (vector<int>::const_iterator i_index = 
                 m_fuseTable[featureindex].begin();
             i_index != m_fuseTable[featureindex].end(); 
             i_index++)
         {
             int index = *i_index;
-            w.Weight() += allweights->Get(index).Weight();
+            w.AddWeight(allweights->Get(index).Weight());
         }
     }
 }
@@ -201,8 +201,8 @@ void RlLocalShapeUnshare::Convert(const RlWeightSet* sharedweights,
                     unsharedset, localunsharedindex);
                 int globalsharedindex = m_sharedShapeSet->GetFeatureIndex(
                     sharedset, localsharedindex);
-                unsharedweights->Get(globalunsharedindex).Weight() 
-                    += sharedweights->Get(globalsharedindex).Weight() * sign;
+                unsharedweights->Get(globalunsharedindex).AddWeight(
+                    sharedweights->Get(globalsharedindex).Weight() * sign);
             }
         }
     }
@@ -55,12 +55,12 @@ void RlLocalShapeFeatures::Initialise()
     RlBinaryFeatures::Initialise();
 }
 
-RlTracker* RlLocalShapeFeatures::CreateTracker(
+RlTracker* RlLocalShapeFeatures::CreateTracker(GoBoard& board,
     map<RlBinaryFeatures*, RlTracker*>& trackermap)
 {
     SG_UNUSED(trackermap);
     SG_ASSERT(IsInitialised());
-    return new RlLocalShapeTracker(m_board, this);
+    return new RlLocalShapeTracker(board, this);
 }
 
 int RlLocalShapeFeatures::ReadFeature(istream& desc) const
@@ -362,16 +362,24 @@ int RlLocalShapeFeatures::LocalMove(
     int oldshapeindex, newshapeindex, anchorindex, x, y;
     DecodeIndex(featureindex, oldshapeindex, anchorindex, x, y);
 
+    newshapeindex = LocalShapeMove(oldshapeindex, mx, my, sh);
+    if (newshapeindex == -1)
+        return -1;
+    return EncodeIndex(newshapeindex, anchorindex);
+}
+
+int RlLocalShapeFeatures::LocalShapeMove(
+    int shapeindex, int mx, int my, int sh) const
+{
     // Get shape index after local move
     RlLocalShape shape(m_xSize, m_ySize);
-    shape.SetShapeIndex(oldshapeindex);
+    shape.SetShapeIndex(shapeindex);
     if ((shape.GetPoint(mx, my) == eEmpty && sh == eEmpty)
         || (shape.GetPoint(mx, my) != eEmpty && sh != eEmpty))
         return -1;
         
     shape.GetPoint(mx, my) = sh;
-    newshapeindex = shape.GetShapeIndex();
-    return EncodeIndex(newshapeindex, anchorindex);
+    return shape.GetShapeIndex();
 }
 
 bool RlLocalShapeFeatures::IsEmpty(int featureindex) const
@@ -26,7 +26,7 @@ public:
     virtual void Initialise();
 
     /** Create corresponding object for incremental tracking */
-    virtual RlTracker* CreateTracker(
+    virtual RlTracker* CreateTracker(GoBoard& board,
         std::map<RlBinaryFeatures*, RlTracker*>& trackermap);
 
     /** Total number of features */
@@ -81,6 +81,10 @@ public:
     
     /** Make a local move in the shape */
     int LocalMove(int featureindex, int x, int y, int c) const;
+
+    /** Make a local move in a shape, independent of anchor position.
+        Returns the new shape index, or -1 if the move is illegal. */
+    int LocalShapeMove(int shapeindex, int x, int y, int c) const;
         
     int GetXSize() const { return m_xSize; }
     int GetYSize() const { return m_ySize; }
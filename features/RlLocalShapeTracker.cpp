@@ -11,6 +11,7 @@
 #include "RlLocalShape.h"
 #include "RlLocalShapeFeatures.h"
 #include "RlSetup.h"
+#include "RlSimdUtil.h"
 #include "SgDebug.h"
 #include <boost/filesystem/path.hpp>
 #include <boost/filesystem/fstream.hpp>
@@ -26,27 +27,35 @@ RlLocalShapeTracker::RlLocalShapeTracker(GoBoard& board,
     RlLocalShapeFeatures* shapes, bool successorFile)
 :   RlTracker(board),
     m_shapes(shapes),
-    m_successorFile(successorFile)
+    m_successorFile(successorFile),
+    m_successor(0),
+    m_ignore(0),
+    m_madeSuccessor(0),
+    m_madeIgnore(0)
 {
     m_shapes->EnsureInitialised();
 
     m_numLocal = m_shapes->GetXSize() * m_shapes->GetYSize() * 3;
-    m_numEntries = m_shapes->GetNumFeatures() * m_numLocal;
-    m_successor = new int[m_numEntries];
-    m_ignore = new bool[m_shapes->GetNumFeatures()];
+    m_numEntries = m_shapes->GetNumShapes() * m_numLocal;
+
+    for (int y = 0; y < m_shapes->GetYNum(); ++y)
+        for (int x = 0; x < m_shapes->GetXNum(); ++x)
+            m_anchorIndex[Pt(x + 1, y + 1)] = m_shapes->GetAnchorIndex(x, y);
 
     MakeLocalMoves();
     if (!LoadSuccessors())
     {
         MakeSuccessors();
-        SaveSuccessors();
+
+        // Map the saved file, so that pages are shared with other processes
+        if (SaveSuccessors() && LoadSuccessors())
+            FreeSuccessors();
     }
 }
 
 RlLocalShapeTracker::~RlLocalShapeTracker()
 {
-    delete [] m_successor;
-    delete [] m_ignore;
+    FreeSuccessors();
 }
 
 void RlLocalShapeTracker::Reset()
@@ -60,9 +69,9 @@ void RlLocalShapeTracker::Reset()
             for (int x = 0; x < m_shapes->GetXNum(); ++x)
             {
                 SgPoint pt = Pt(x + 1, y + 1);
-                m_index[pt] = m_markIndex[pt];
-                if (!m_ignore[m_index[pt]])
-                    NewChange(GetOffset(pt), m_index[pt], +1);
+                m_shape[pt] = m_markShape[pt];
+                if (!m_ignore[m_shape[pt]])
+                    NewChange(GetOffset(pt), GetFeatureIndex(pt), +1);
             }
         }
     }
@@ -72,11 +81,7 @@ void RlLocalShapeTracker::Reset()
         for (int y = 0; y < m_shapes->GetYNum(); ++y)
         {
             for (int x = 0; x < m_shapes->GetXNum(); ++x)
-            {
-                SgPoint pt = Pt(x + 1, y + 1);
-                m_index[pt] = m_shapes->EncodeIndex(
-                    0, m_shapes->GetAnchorIndex(x, y));
-            }
+                m_shape[Pt(x + 1, y + 1)] = 0;
         }
         
         // Update once for each stone on the board
@@ -89,12 +94,12 @@ void RlLocalShapeTracker::Reset()
                 SgBlackWhite colour = m_board.GetColor(stone);
 
                 int c = ColourIndex(colour);
-                vector<LocalMove>& localmoves = m_localMoves[c][stone];
-                for (vector<LocalMove>::iterator i_local = localmoves.begin(); 
-                    i_local != localmoves.end(); ++i_local)
+                const LocalMove* end = LocalMovesEnd(c, stone);
+                for (const LocalMove* i_local = LocalMovesBegin(c, stone); 
+                    i_local != end; ++i_local)
                 {
-                    m_index[i_local->m_anchor] = GetSuccessor(
-                        m_index[i_local->m_anchor], i_local->m_localMove);
+                    m_shape[i_local->m_anchor] = GetSuccessor(
+                        m_shape[i_local->m_anchor], i_local->m_localMove);
                 }
             }
         }
@@ -105,8 +110,8 @@ void RlLocalShapeTracker::Reset()
             for (int x = 0; x < m_shapes->GetXNum(); ++x)
             {
                 SgPoint pt = Pt(x + 1, y + 1);
-                if (!m_ignore[m_index[pt]])
-                    NewChange(GetOffset(pt), m_index[pt], +1);
+                if (!m_ignore[m_shape[pt]])
+                    NewChange(GetOffset(pt), GetFeatureIndex(pt), +1);
             }
         }
     }
@@ -142,6 +147,16 @@ void RlLocalShapeTracker::Execute(SgMove move, SgBlackWhite colour,
         m_step++;
 }
 
+bool RlLocalShapeTracker::ExecuteHypothetical(SgMove move, 
+    SgBlackWhite colour)
+{
+    // Without captures, only the successors of the played point change
+    RlTracker::ExecuteHypothetical(move, colour);
+    if (move != SG_PASS)
+        UpdateStone(move, colour, false, false);
+    return true;
+}
+
 void RlLocalShapeTracker::Undo()
 {
     RlTracker::Undo();
@@ -154,12 +169,13 @@ void RlLocalShapeTracker::Undo()
             break;
         m_changes.pop_back();
         
-        int slot = GetOffset(change.m_anchor);
-        if (!m_ignore[m_index[change.m_anchor]])
-            NewChange(slot, m_index[change.m_anchor], -1);
-        m_index[change.m_anchor] = change.m_index;
-        if (!m_ignore[m_index[change.m_anchor]])
-            NewChange(slot, m_index[change.m_anchor], +1);
+        SgPoint anchor = change.m_anchor;
+        int slot = GetOffset(anchor);
+        if (!m_ignore[m_shape[anchor]])
+            NewChange(slot, GetFeatureIndex(anchor), -1);
+        m_shape[anchor] = change.m_shape;
+        if (!m_ignore[m_shape[anchor]])
+            NewChange(slot, GetFeatureIndex(anchor), +1);
     }
 
     if (RlSetup::Get()->GetVerification())
@@ -170,34 +186,43 @@ void RlLocalShapeTracker::UpdateStone(SgPoint stone, SgEmptyBlackWhite colour,
     bool execute, bool store)
 {
     int c = ColourIndex(colour);
-    vector<LocalMove>& localmoves = m_localMoves[c][stone];
-    for (vector<LocalMove>::iterator i_local = localmoves.begin(); 
-        i_local != localmoves.end(); ++i_local)
+    const LocalMove* begin = LocalMovesBegin(c, stone);
+    const LocalMove* end = LocalMovesEnd(c, stone);
+
+#ifdef RL_PREFETCH
+    // Successor lookups of different anchors are independent, so fetch 
+    // all their table entries before the first one is needed
+    for (const LocalMove* i_local = begin; i_local != end; ++i_local)
+        __builtin_prefetch(m_successor 
+            + m_shape[i_local->m_anchor] * m_numLocal 
+            + i_local->m_localMove);
+#endif
+
+    for (const LocalMove* i_local = begin; i_local != end; ++i_local)
     {
         SgPoint anchor = i_local->m_anchor;
+        int slot = i_local->m_slot;
         if (execute)
         {
-            int slot = GetOffset(anchor);
             if (store)
                 Store(anchor);
-            if (!m_ignore[m_index[anchor]])
-                NewChange(slot, m_index[anchor], -1);
+            if (!m_ignore[m_shape[anchor]])
+                NewChange(slot, GetFeatureIndex(anchor), -1);
                 
-            m_index[anchor] = GetSuccessor(
-                m_index[anchor], i_local->m_localMove);
-            assert(m_index[anchor] != -1);
-            if (!m_ignore[m_index[anchor]])
-                NewChange(slot, m_index[anchor], +1);
+            m_shape[anchor] = GetSuccessor(
+                m_shape[anchor], i_local->m_localMove);
+            if (!m_ignore[m_shape[anchor]])
+                NewChange(slot, GetFeatureIndex(anchor), +1);
         }
         else
         {
-            int slot = GetOffset(anchor);
-            if (!m_ignore[m_index[anchor]])
-                NewChange(slot, m_index[anchor], -1);
+            if (!m_ignore[m_shape[anchor]])
+                NewChange(slot, GetFeatureIndex(anchor), -1);
             int successor = GetSuccessor(
-                m_index[anchor], i_local->m_localMove);
+                m_shape[anchor], i_local->m_localMove);
             if (!m_ignore[successor])
-                NewChange(slot, successor, +1);
+                NewChange(slot, m_shapes->EncodeIndex(
+                    successor, m_anchorIndex[anchor]), +1);
         }
     }
 }
@@ -210,7 +235,7 @@ void RlLocalShapeTracker::SetMark()
         for (int x = 0; x < m_shapes->GetXNum(); ++x)
         {
             SgPoint pt = Pt(x + 1, y + 1);
-            m_markIndex[pt] = m_index[pt];
+            m_markShape[pt] = m_shape[pt];
         }
     }
 }
@@ -257,12 +282,21 @@ void RlLocalShapeTracker::UpdateDirty(SgPoint stone, RlDirtySet& dirty)
 
 void RlLocalShapeTracker::MakeLocalMoves()
 {
+    // Lists are packed in order of colour and point, so that each list
+    // ends where the next one starts
+    SG_ASSERT(m_numLocal <= 0x10000);
+    SgArray<bool, SG_MAXPOINT> onboard(false);
+    for (GoBoard::Iterator i_board(m_board); i_board; ++i_board)
+        onboard[*i_board] = true;
+
+    m_localMoves.clear();
     for (int c = 0; c < 3; ++c)
     {
-        for (GoBoard::Iterator i_board(m_board); i_board; ++i_board)
+        for (SgPoint point = 0; point < SG_MAXPOINT; ++point)
         {
-            SgPoint point = *i_board;
-            m_localMoves[c][point].clear();
+            m_localStart[c][point] = m_localMoves.size();
+            if (!onboard[point])
+                continue;
             
             // Anchors of local shape affected by this stone
             int col = Col(point);
@@ -278,11 +312,13 @@ void RlLocalShapeTracker::MakeLocalMoves()
                 {
                     LocalMove localmove;
                     localmove.m_anchor = Pt(x, y);
+                    localmove.m_slot = GetOffset(Pt(x, y));
                     localmove.m_localMove = GetLocalMove(col - x, row - y, c);
-                    m_localMoves[c][point].push_back(localmove);
+                    m_localMoves.push_back(localmove);
                 }
             }            
         }
+        m_localStart[c][SG_MAXPOINT] = m_localMoves.size();
     }
 }
 
@@ -290,40 +326,69 @@ void RlLocalShapeTracker::MakeSuccessors()
 {
     RlDebug(RlSetup::VOCAL) << "Making successors for " 
         << m_shapes->SetName() << "...";
-    for (int index = 0; index < m_shapes->GetNumFeatures(); ++index)
+    FreeSuccessors();
+    m_madeSuccessor = new int[m_numEntries];
+    m_madeIgnore = new bool[m_shapes->GetNumShapes()];
+    for (int shape = 0; shape < m_shapes->GetNumShapes(); ++shape)
         for (int x = 0; x < m_shapes->GetXSize(); ++x)
             for (int y = 0; y < m_shapes->GetYSize(); ++y)
                 for (int c = 0; c < 3; ++c)
-                    m_successor[index * m_numLocal + GetLocalMove(x, y, c)] 
-                        = m_shapes->LocalMove(index, x, y, c);
-    for (int index = 0; index < m_shapes->GetNumFeatures(); ++index)
-        m_ignore[index] = m_shapes->IsEmpty(index);
+                    m_madeSuccessor[shape * m_numLocal 
+                        + GetLocalMove(x, y, c)] 
+                        = m_shapes->LocalShapeMove(shape, x, y, c);
+    for (int shape = 0; shape < m_shapes->GetNumShapes(); ++shape)
+        m_madeIgnore[shape] = (shape == 0);
+    m_successor = m_madeSuccessor;
+    m_ignore = m_madeIgnore;
     RlDebug(RlSetup::VOCAL) << " done\n";
 }
 
+void RlLocalShapeTracker::FreeSuccessors()
+{
+    delete [] m_madeSuccessor;
+    delete [] m_madeIgnore;
+    m_madeSuccessor = 0;
+    m_madeIgnore = 0;
+}
+
 bfs::path RlLocalShapeTracker::GetFileName()
 {
     ostringstream oss;
-    oss << "Successors-" 
-        << m_board.Size() << "x" << m_board.Size() << "-"
+    // Successors are indexed by shape only, so one file serves all 
+    // board sizes
+    oss << "Successors-Shape-" 
         << m_shapes->GetXSize() << "x" << m_shapes->GetYSize()
         << ".dat";
     return GetInputPath() / oss.str();
 }
 
+RlTableHeader RlLocalShapeTracker::GetTableHeader() const
+{
+    // Successors are independent of board size and anchor position
+    RlTableHeader header(1);
+    header.m_xSize = m_shapes->GetXSize();
+    header.m_ySize = m_shapes->GetYSize();
+    header.m_numFeatures = m_shapes->GetNumShapes();
+    header.m_numOutputs = m_numLocal;
+    header.m_dataBytes = m_numEntries * sizeof(int) 
+        + m_shapes->GetNumShapes() * sizeof(bool);
+    return header;
+}
+
 bool RlLocalShapeTracker::LoadSuccessors()
 {
     if (!m_successorFile)
         return false;
 
-    bfs::ifstream succ(GetFileName(), ios::binary);
-    if (!succ)
+    // Missing or stale files are silently regenerated
+    if (!m_successorTable.Open(GetFileName(), GetTableHeader(), 
+        RlSetup::Get()->GetVerification()))
         return false;
-    RlDebug(RlSetup::VOCAL) << "Loading successors for " 
-        << m_shapes->SetName() << "...";
-    succ.read((char*) m_successor, m_numEntries * sizeof(int));
-    succ.read((char*) m_ignore, m_shapes->GetNumFeatures() * sizeof(bool));
-    RlDebug(RlSetup::VOCAL) << " done\n";
+
+    RlDebug(RlSetup::VOCAL) << "Mapped successors for " 
+        << m_shapes->SetName() << "\n";
+    m_successor = reinterpret_cast<const int*>(m_successorTable.GetData());
+    m_ignore = reinterpret_cast<const bool*>(m_successor + m_numEntries);
     return true;
 }
 
@@ -332,14 +397,18 @@ bool RlLocalShapeTracker::SaveSuccessors()
     if (!m_successorFile)
         return false;
 
-    bfs::ofstream succ(GetFileName(), ios::binary);
-    if (!succ)
-        return false;
-        
     RlDebug(RlSetup::VOCAL) << "Saving successors for " 
         << m_shapes->SetName() << "...";
-    succ.write((char*) m_successor, m_numEntries * sizeof(int));
-    succ.write((char*) m_ignore, m_shapes->GetNumFeatures() * sizeof(bool));
+    RlMappedTable::BlockList blocks;
+    blocks.push_back(make_pair((const char*) m_successor, 
+        (int) (m_numEntries * sizeof(int))));
+    blocks.push_back(make_pair((const char*) m_ignore,
+        (int) (m_shapes->GetNumShapes() * sizeof(bool))));
+    if (!RlMappedTable::Save(GetFileName(), GetTableHeader(), blocks))
+    {
+        RlDebug(RlSetup::VOCAL) << " failed\n";
+        return false;
+    }
     RlDebug(RlSetup::VOCAL) << " done\n";
     return true;
 }
@@ -352,20 +421,28 @@ void RlLocalShapeTracker::DeleteSuccessorFile()
 }
 
 int RlLocalShapeTracker::GetSuccessor(
-    int index, int x, int y, int c) const
+    int featureindex, int x, int y, int c) const
 {
-    return GetSuccessor(index, GetLocalMove(x, y, c));
+    int shapeindex, anchorindex, ax, ay;
+    m_shapes->DecodeIndex(featureindex, shapeindex, anchorindex, ax, ay);
+    int successor = GetSuccessor(shapeindex, GetLocalMove(x, y, c));
+    return m_shapes->EncodeIndex(successor, anchorindex);
 }
 
-
-inline int RlLocalShapeTracker::GetSuccessor(int index, int localmove) const
+inline int RlLocalShapeTracker::GetSuccessor(
+    int shapeindex, int localmove) const
 {
-    int successor = m_successor[index * m_numLocal + localmove];
+    int successor = m_successor[shapeindex * m_numLocal + localmove];
     SG_ASSERT(successor >= 0
-              && successor < m_shapes->GetNumFeatures());
+              && successor < m_shapes->GetNumShapes());
     return successor;
 }
 
+inline int RlLocalShapeTracker::GetFeatureIndex(SgPoint anchor) const
+{
+    return m_shapes->EncodeIndex(m_shape[anchor], m_anchorIndex[anchor]);
+}
+
 inline int RlLocalShapeTracker::GetLocalMove(
     int x, int y, int c) const
 {
@@ -373,6 +450,18 @@ inline int RlLocalShapeTracker::GetLocalMove(
     return pos * 3 + c;
 }
 
+inline const RlLocalShapeTracker::LocalMove* 
+RlLocalShapeTracker::LocalMovesBegin(int c, SgPoint point) const
+{
+    return &m_localMoves[0] + m_localStart[c][point];
+}
+
+inline const RlLocalShapeTracker::LocalMove* 
+RlLocalShapeTracker::LocalMovesEnd(int c, SgPoint point) const
+{
+    return &m_localMoves[0] + m_localStart[c][point + 1];
+}
+
 inline int RlLocalShapeTracker::GetOffset(SgPoint anchor) const
 {
     return (Row(anchor) - 1) * m_shapes->GetXNum() 
@@ -381,7 +470,7 @@ inline int RlLocalShapeTracker::GetOffset(SgPoint anchor) const
 
 inline void RlLocalShapeTracker::Store(SgPoint anchor)
 {
-    m_changes.push_back(Change(m_step, anchor, m_index[anchor]));
+    m_changes.push_back(Change(m_step, anchor, m_shape[anchor]));
 }
 
 void RlLocalShapeTracker::Verify() const
@@ -396,8 +485,8 @@ void RlLocalShapeTracker::Verify() const
             localshape.SetFromBoard(m_board, x + 1, y + 1);
             int anchorindex = m_shapes->GetAnchorIndex(x, y);
             int shapeindex = localshape.GetShapeIndex();
-            int index = m_shapes->EncodeIndex(shapeindex, anchorindex);
-            if (index != m_index[point])
+            if (shapeindex != m_shape[point]
+                || anchorindex != m_anchorIndex[point])
                 throw SgException("Incremental update error");
         }
     }
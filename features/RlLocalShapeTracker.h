@@ -8,6 +8,8 @@
 #define RLLOCALSHAPETRACKER_H
 
 #include "RlTracker.h"
+#include "RlProcessUtil.h"
+#include <boost/cstdint.hpp>
 
 class RlLocalShapeFeatures;
 
@@ -31,6 +33,9 @@ public:
     /** Incremental undo */
     virtual void Undo();
 
+    /** Changes for a non-capturing move, without updating board */
+    virtual bool ExecuteHypothetical(SgMove move, SgBlackWhite colour);
+
     /** Update dirty moves */
     virtual void UpdateDirty(SgMove move, SgBlackWhite colour, 
         RlDirtySet& dirty);
@@ -41,8 +46,8 @@ public:
     /** Size of active set */
     virtual int GetActiveSize() const;
 
-    /** Lookup successor from table */
-    int GetSuccessor(int index, int x, int y, int c) const;
+    /** Lookup successor feature from table */
+    int GetSuccessor(int featureindex, int x, int y, int c) const;
 
     /** Verify that all indices correctly correspond to board */
     void Verify() const;
@@ -62,15 +67,20 @@ protected:
     /** Lookup local move index */
     int GetLocalMove(int x, int y, int c) const;
 
-    /** Lookup successor from table using local move index */
-    int GetSuccessor(int index, int localmove) const;
+    /** Lookup successor shape from table using local move index */
+    int GetSuccessor(int shapeindex, int localmove) const;
+
+    /** Feature index for the current shape at an anchor point */
+    int GetFeatureIndex(SgPoint anchor) const;
         
     void UpdateDirty(SgPoint stone, RlDirtySet& dirty);
     int GetOffset(SgPoint anchor) const;
     void Store(SgPoint point);
     void MakeSuccessors();
+    void FreeSuccessors();
     void MakeLocalMoves();
     bfs::path GetFileName();
+    RlTableHeader GetTableHeader() const;
     bool LoadSuccessors();
     bool SaveSuccessors();
 
@@ -82,41 +92,64 @@ protected:
     /** Whether to load/save successors to a file */
     bool m_successorFile;
 
-    /** Current set of feature indices */
-    SgArray<int, SG_MAXPOINT> m_index;
+    /** Current shape index at each anchor point */
+    SgArray<int, SG_MAXPOINT> m_shape;
     
-    /** Stored set of feature indices for fast resetting */
-    SgArray<int, SG_MAXPOINT> m_markIndex;
+    /** Stored set of shape indices for fast resetting */
+    SgArray<int, SG_MAXPOINT> m_markShape;
 
-    /** Successor table */
-    int* m_successor;
+    /** Anchor index of each anchor point */
+    SgArray<int, SG_MAXPOINT> m_anchorIndex;
+
+    /** Successor table, indexed by shape index and local move.
+        Local moves never change the anchor, so the table is independent
+        of anchor position and board size: the anchor is reapplied to the
+        successor shape by EncodeIndex. */
+    const int* m_successor;
     
-    /** Features to ignore (don't include in change list) */
-    bool* m_ignore;
+    /** Shapes to ignore (don't include in change list) */
+    const bool* m_ignore;
+
+    /** Successor file, mapped read-only and shared between processes */
+    RlMappedTable m_successorTable;
+
+    /** Successor tables generated by this process (if not mapped) */
+    int* m_madeSuccessor;
+    bool* m_madeIgnore;
 
     /** Stored changes for subsequent undo */
     struct Change
     {
-        Change(int step, SgPoint anchor, int index)
-        :   m_step(step), m_anchor(anchor), m_index(index) { }
+        Change(int step, SgPoint anchor, int shape)
+        :   m_step(step), m_anchor(anchor), m_shape(shape) { }
         
         int m_step;
         SgPoint m_anchor;
-        int m_index;
+        int m_shape;
     };
     
     std::vector<Change> m_changes;
     int m_step;
 
     /** Successor data is stored according to a local move index 
-        at each specified anchor point */
+        at each specified anchor point. The slot of the anchor 
+        (see GetOffset) is stored with it. */
     struct LocalMove
     {
-        SgPoint m_anchor;
-        int m_localMove;
+        boost::uint16_t m_anchor;
+        boost::uint16_t m_slot;
+        boost::uint16_t m_localMove;
     };
 
-    std::vector<LocalMove> m_localMoves[3][SG_MAXPOINT];
+    /** Local moves for all colours and points, packed into one array */
+    std::vector<LocalMove> m_localMoves;
+
+    /** Local moves of colour index c at point p are in the range 
+        [m_localStart[c][p], m_localStart[c][p + 1]) of m_localMoves */
+    int m_localStart[3][SG_MAXPOINT + 1];
+
+    const LocalMove* LocalMovesBegin(int c, SgPoint point) const;
+    const LocalMove* LocalMovesEnd(int c, SgPoint point) const;
 
     int m_numLocal;
     int m_numEntries;
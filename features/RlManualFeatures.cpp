@@ -33,12 +33,12 @@ void RlManualFeatureSet::Initialise()
     RlBinaryFeatures::Initialise();
 }
 
-RlTracker* RlManualFeatureSet::CreateTracker(
+RlTracker* RlManualFeatureSet::CreateTracker(GoBoard& board,
     map<RlBinaryFeatures*, RlTracker*>& trackermap)
 {
     SG_UNUSED(trackermap);
     SG_ASSERT(IsInitialised());
-    return new RlManualTracker(m_board, this);
+    return new RlManualTracker(board, this);
 }
 
 void RlManualFeatureSet::Clear()
@@ -26,9 +26,12 @@ public:
     void LoadSettings(std::istream& settings);
 
     /** Create corresponding object for incremental tracking */
-    virtual RlTracker* CreateTracker(
+    virtual RlTracker* CreateTracker(GoBoard& board,
         std::map<RlBinaryFeatures*, RlTracker*>& trackermap);
 
+    /** Feature values are set manually, so can't be shared */
+    virtual bool IsReadOnly() const { return false; }
+
     /** Get the total number of features currently in this set */
     virtual int GetNumFeatures() const;
 
@@ -34,11 +34,11 @@ void RlProductFeatures::Initialise()
     RlCompoundFeatures::Initialise();
 }
 
-RlTracker* RlProductFeatures::CreateTracker(
+RlTracker* RlProductFeatures::CreateTracker(GoBoard& board,
     map<RlBinaryFeatures*, RlTracker*>& trackermap)
 {
-    CreateChildTrackers(trackermap);
-    return new RlProductTracker(m_board, this,
+    CreateChildTrackers(board, trackermap);
+    return new RlProductTracker(board, this,
         trackermap[m_set1], trackermap[m_set2]);
 }
 
@@ -24,7 +24,7 @@ public:
     virtual void Initialise();
 
     /** Create corresponding object for incremental tracking */
-    virtual RlTracker* CreateTracker(
+    virtual RlTracker* CreateTracker(GoBoard& board,
         std::map<RlBinaryFeatures*, RlTracker*>& trackermap);
 
     /** Get the total number of features currently in this set */
@@ -29,6 +29,8 @@ RlSharedFeatures::RlSharedFeatures(GoBoard& board,
     m_numOutputFeatures(0), // calculated during Initialise
     m_lookup(0),
     m_inverseMap(0),
+    m_madeLookup(0),
+    m_madeInverseMap(0),
     m_selfInverse(true),
     m_tableFile(true)
 {
@@ -36,10 +38,15 @@ RlSharedFeatures::RlSharedFeatures(GoBoard& board,
 
 RlSharedFeatures::~RlSharedFeatures()
 {
-    if (m_lookup)
-        delete [] m_lookup;
-    if (m_inverseMap)
-        delete [] m_inverseMap;
+    FreeTables();
+}
+
+void RlSharedFeatures::FreeTables()
+{
+    delete [] m_madeLookup;
+    delete [] m_madeInverseMap;
+    m_madeLookup = 0;
+    m_madeInverseMap = 0;
 }
 
 void RlSharedFeatures::LoadSettings(std::istream& settings)
@@ -61,17 +68,20 @@ void RlSharedFeatures::Initialise()
     if (!LoadTables())
     {
         MakeTables();
-        SaveTables();
+
+        // Map the saved file, so that pages are shared with other processes
+        if (SaveTables() && LoadTables())
+            FreeTables();
     }
 }
 
-RlTracker* RlSharedFeatures::CreateTracker(
+RlTracker* RlSharedFeatures::CreateTracker(GoBoard& board,
     map<RlBinaryFeatures*, RlTracker*>& trackermap)
 {
     SG_UNUSED(trackermap);
     SG_ASSERT(IsInitialised());
-    CreateChildTrackers(trackermap);
-    return new RlSharedTracker(m_board, this, trackermap[FeatureSet()]);
+    CreateChildTrackers(board, trackermap);
+    return new RlSharedTracker(board, this, trackermap[FeatureSet()]);
 }
 
 void RlSharedFeatures::MakeTables()
@@ -80,8 +90,13 @@ void RlSharedFeatures::MakeTables()
         << SetName() << "...";
     m_numInputFeatures = FeatureSet()->GetNumFeatures();
     m_numOutputFeatures = 0;
-    m_lookup = new Lookup[m_numInputFeatures];
-    m_inverseMap = new int[m_numInputFeatures]; // Only need outputs
+    FreeTables();
+    Lookup* lookup = new Lookup[m_numInputFeatures];
+    int* inversemap = new int[m_numInputFeatures]; // Only need outputs
+    m_madeLookup = lookup;
+    m_madeInverseMap = inversemap;
+    m_lookup = lookup;
+    m_inverseMap = inversemap;
 
     for (int i = 0; i < m_numInputFeatures; ++i)
     {
@@ -94,17 +109,17 @@ void RlSharedFeatures::MakeTables()
         {
             if (sign)
             {
-                m_lookup[i].m_index = m_numOutputFeatures;
-                m_lookup[i].m_sign = sign;
-                m_inverseMap[m_numOutputFeatures] = canonical;
+                lookup[i].m_index = m_numOutputFeatures;
+                lookup[i].m_sign = sign;
+                inversemap[m_numOutputFeatures] = canonical;
                 m_numOutputFeatures++;
             }
             
             // Ignore features with sign zero
             else
             {
-                m_lookup[i].m_index = -1;
-                m_lookup[i].m_sign = 0;
+                lookup[i].m_index = -1;
+                lookup[i].m_sign = 0;
             }
         }
         
@@ -116,8 +131,8 @@ void RlSharedFeatures::MakeTables()
         else
         {
             SG_ASSERT(canonical < i);
-            m_lookup[i].m_index = m_lookup[canonical].m_index;
-            m_lookup[i].m_sign = sign;
+            lookup[i].m_index = lookup[canonical].m_index;
+            lookup[i].m_sign = sign;
         }        
     }    
 
@@ -220,29 +235,41 @@ bfs::path RlSharedFeatures::TablePath() const
     return filename;
 }
 
+RlTableHeader RlSharedFeatures::TableHeader() const
+{
+    RlTableHeader header(2);
+    header.m_boardSize = m_board.Size();
+    header.m_symmetry = GetSymmetry();
+    header.m_flags = m_selfInverse ? 1 : 0;
+    header.m_numFeatures = FeatureSet()->GetNumFeatures();
+    return header;
+}
+
 bool RlSharedFeatures::LoadTables()
 {
     if (!m_tableFile)
         return false;
 
-    bfs::ifstream tables(TablePath(), ios::binary | ios::in);
-    if (!tables)
+    // Missing or stale files are silently regenerated
+    if (!m_table.Open(TablePath(), TableHeader(), 
+        RlSetup::Get()->GetVerification()))
         return false;
     
-    RlDebug(RlSetup::VOCAL) << "Loading share table for " 
-        << SetName() << "...";
-
-    int version;
-    tables >> RlVersion(version, 1, 1);
-    tables >> RlSetting<int>("NumInputFeatures", m_numInputFeatures);
-    tables >> RlSetting<int>("NumOutputFeatures", m_numOutputFeatures);
-
-    m_lookup = new Lookup[m_numInputFeatures];
-    m_inverseMap = new int[m_numOutputFeatures];
+    const RlTableHeader& header = m_table.GetHeader();
+    m_numInputFeatures = header.m_numFeatures;
+    m_numOutputFeatures = header.m_numOutputs;
+    if (header.m_dataBytes != (int) (m_numInputFeatures * sizeof(Lookup)
+        + m_numOutputFeatures * sizeof(int)))
+    {
+        m_table.Close();
+        return false;
+    }
 
-    tables.read((char*) m_lookup, m_numInputFeatures * sizeof(Lookup));
-    tables.read((char*) m_inverseMap, m_numOutputFeatures * sizeof(int));
-    RlDebug(RlSetup::VOCAL) << " done\n";
+    RlDebug(RlSetup::VOCAL) << "Mapped share table for " 
+        << SetName() << "\n";
+    m_lookup = reinterpret_cast<const Lookup*>(m_table.GetData());
+    m_inverseMap = reinterpret_cast<const int*>(
+        m_lookup + m_numInputFeatures);
     return true;
 }
 
@@ -255,16 +282,18 @@ bool RlSharedFeatures::SaveTables()
         << SetName() << "...";
     
     bfs::create_directories(TablePath().branch_path());
-    bfs::ofstream tables(TablePath(), ios::binary | ios::out);
-    if (!tables)
+    RlTableHeader header = TableHeader();
+    header.m_numOutputs = m_numOutputFeatures;
+    RlMappedTable::BlockList blocks;
+    blocks.push_back(make_pair((const char*) m_lookup, 
+        (int) (m_numInputFeatures * sizeof(Lookup))));
+    blocks.push_back(make_pair((const char*) m_inverseMap,
+        (int) (m_numOutputFeatures * sizeof(int))));
+    if (!RlMappedTable::Save(TablePath(), header, blocks))
+    {
+        RlDebug(RlSetup::VOCAL) << " failed\n";
         return false;
-    
-    tables << RlVersion(1);
-    tables << RlSetting<int>("NumInputFeatures", m_numInputFeatures);
-    tables << RlSetting<int>("NumOutputFeatures", m_numOutputFeatures);
-
-    tables.write((char*) m_lookup, m_numInputFeatures * sizeof(Lookup));
-    tables.write((char*) m_inverseMap, m_numOutputFeatures * sizeof(int));
+    }
     RlDebug(RlSetup::VOCAL) << " done\n";
     return true;
 }
@@ -392,6 +421,15 @@ void RlSharedTracker::Execute(SgMove move, SgBlackWhite colour,
     ShareChanges();
 }
 
+bool RlSharedTracker::ExecuteHypothetical(SgMove move, 
+    SgBlackWhite colour)
+{
+    if (!RlCompoundTracker::ExecuteHypothetical(move, colour))
+        return false;
+    ShareChanges();
+    return true;
+}
+
 void RlSharedTracker::Undo()
 {
     RlCompoundTracker::Undo();
@@ -8,6 +8,7 @@
 #define RLSHAREDFEATURES_H
 
 #include "RlCompoundFeatures.h"
+#include "RlProcessUtil.h"
 #include "RlUtils.h"
 #include <vector>
 
@@ -65,6 +66,9 @@ public:
     /** Get number of input features */
     int GetNumInputFeatures() const { return m_numInputFeatures; }
 
+    /** Symmetries used to define equivalence classes */
+    virtual int GetSymmetry() const { return RlShapeUtil::eNone; }
+
     //------------------------------------------------------------------------
     // RlBinaryFeatures virtual functions
 
@@ -75,7 +79,7 @@ public:
     virtual void LoadSettings(std::istream& settings);
     
     /** Create corresponding object for incremental tracking */
-    virtual RlTracker* CreateTracker(
+    virtual RlTracker* CreateTracker(GoBoard& board,
         std::map<RlBinaryFeatures*, RlTracker*>& trackermap);
 
     /** Number of output features */
@@ -138,6 +142,12 @@ protected:
     /** Get filename to use for lookup tables */
     bfs::path TablePath() const;
 
+    /** Expected header of lookup table file */
+    RlTableHeader TableHeader() const;
+
+    /** Free lookup tables made by this process */
+    void FreeTables();
+
 private:
 
     struct Lookup
@@ -149,8 +159,15 @@ private:
     RlBinaryFeatures* m_featureSet;
     int m_numInputFeatures;
     int m_numOutputFeatures;
-    Lookup* m_lookup;
-    int* m_inverseMap; // Inverse lookup from output to canonical features
+    const Lookup* m_lookup;
+    const int* m_inverseMap; // Inverse lookup from output to canonical
+
+    /** Lookup table file, mapped read-only and shared between processes */
+    RlMappedTable m_table;
+
+    /** Lookup tables made by this process (if not mapped) */
+    Lookup* m_madeLookup;
+    int* m_madeInverseMap;
 
     bool m_selfInverse;
     bool m_tableFile;
@@ -175,6 +192,9 @@ public:
     /** Incremental undo */
     virtual void Undo();
 
+    /** Changes for a non-capturing move, without updating board */
+    virtual bool ExecuteHypothetical(SgMove move, SgBlackWhite colour);
+
     /** Size of active set */
     virtual int GetActiveSize() const;
 
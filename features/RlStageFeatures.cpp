@@ -28,12 +28,12 @@ void RlStageFeatures::LoadSettings(istream& settings)
     settings >> RlSetting<int>("MaxStep", m_maxStep);
 }
 
-RlTracker* RlStageFeatures::CreateTracker(
+RlTracker* RlStageFeatures::CreateTracker(GoBoard& board,
     map<RlBinaryFeatures*, RlTracker*>& trackermap)
 {
     SG_UNUSED(trackermap);
     SG_ASSERT(IsInitialised());
-    return new RlStageTracker(m_board, this);
+    return new RlStageTracker(board, this);
 }
 
 int RlStageFeatures::GetNumFeatures() const
@@ -99,6 +99,13 @@ void RlStageTracker::Execute(SgMove move, SgBlackWhite colour,
         m_timeStep++;
 }
 
+bool RlStageTracker::ExecuteHypothetical(SgMove move, SgBlackWhite colour)
+{
+    // Stage only depends on the time step, not on the board
+    Execute(move, colour, false, false);
+    return true;
+}
+
 void RlStageTracker::Undo()
 {
     RlTracker::Undo();
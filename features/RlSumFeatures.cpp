@@ -38,11 +38,11 @@ void RlSumFeatures::Initialise()
     }
 }
 
-RlTracker* RlSumFeatures::CreateTracker(
+RlTracker* RlSumFeatures::CreateTracker(GoBoard& board,
     map<RlBinaryFeatures*, RlTracker*>& trackermap)
 {
-    CreateChildTrackers(trackermap);
-    RlSumTracker* sumtracker = new RlSumTracker(m_board, this);
+    CreateChildTrackers(board, trackermap);
+    RlSumTracker* sumtracker = new RlSumTracker(board, this);
     for (int i = 0; i < ssize(m_featureSets); ++i)
         sumtracker->AddTracker(trackermap[m_featureSets[i]]);
     return sumtracker;
@@ -211,6 +211,14 @@ void RlSumTracker::Execute(SgMove move, SgBlackWhite colour,
     SumChanges();
 }
 
+bool RlSumTracker::ExecuteHypothetical(SgMove move, SgBlackWhite colour)
+{
+    if (!RlCompoundTracker::ExecuteHypothetical(move, colour))
+        return false;
+    SumChanges();
+    return true;
+}
+
 void RlSumTracker::Undo()
 {
     RlCompoundTracker::Undo();
@@ -21,12 +21,12 @@ RlToPlayFeatures::RlToPlayFeatures(GoBoard& board)
 {
 }
 
-RlTracker* RlToPlayFeatures::CreateTracker(
+RlTracker* RlToPlayFeatures::CreateTracker(GoBoard& board,
     map<RlBinaryFeatures*, RlTracker*>& trackermap)
 {
     SG_UNUSED(trackermap);
     SG_ASSERT(IsInitialised());
-    return new RlToPlayTracker(m_board);
+    return new RlToPlayTracker(board);
 }
 
 int RlToPlayFeatures::GetNumFeatures() const
@@ -96,6 +96,23 @@ void RlToPlayTracker::Execute(SgMove move, SgBlackWhite colour,
     }
 }
 
+bool RlToPlayTracker::ExecuteHypothetical(SgMove move, SgBlackWhite colour)
+{
+    RlTracker::ExecuteHypothetical(move, colour);
+    SgBlackWhite newcolour = SgOppBW(colour);
+    if (newcolour == SG_BLACK)
+    {
+        NewChange(0, 0, +1);
+        NewChange(0, 1, -1);
+    }
+    else
+    {
+        NewChange(0, 0, -1);
+        NewChange(0, 1, +1);
+    }
+    return true;
+}
+
 void RlToPlayTracker::Undo()
 {
     RlTracker::Undo();
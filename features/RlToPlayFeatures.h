@@ -23,7 +23,7 @@ public:
     RlToPlayFeatures(GoBoard& board);
     
     /** Create corresponding object for incremental tracking */
-    virtual RlTracker* CreateTracker(
+    virtual RlTracker* CreateTracker(GoBoard& board,
         std::map<RlBinaryFeatures*, RlTracker*>& trackermap);
 
     /** Get the total number of features currently in this set */
@@ -55,6 +55,9 @@ public:
     /** Incremental undo */
     virtual void Undo();
 
+    /** Changes for a non-capturing move, without updating board */
+    virtual bool ExecuteHypothetical(SgMove move, SgBlackWhite colour);
+
     /** Size of active set */
     virtual int GetActiveSize() const;    
 };
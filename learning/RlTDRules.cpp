@@ -67,12 +67,15 @@ void RlLambdaReturn::CalcDelta()
 
 IMPLEMENT_OBJECT(RlTDLambda);
 
+const RlFloat RlTDLambda::s_minScale = 1e-20;
+
 RlTDLambda::RlTDLambda(GoBoard& board, RlWeightSet* wset, RlLogger* log,
     RlFloat lambda, bool replacing)
 :   RlTD0(board, wset, log),
     m_lambda(lambda),
     m_replacing(replacing),
-    m_zeroThreshold(0.001f)
+    m_zeroThreshold(0.001f),
+    m_scale(1)
 {
 }
 
@@ -88,15 +91,18 @@ void RlTDLambda::Start(RlHistory* history, int episode)
 {
     RlLearningRule::Start(history, episode);
 
-    // Clear all eligibility traces and non-zero eligibility list
-    RlWeight::EnsureEligibility();
+    // Clear all eligibility traces
+    if (ssize(m_tracePos) != m_weightSet->GetNumFeatures())
+    {
+        m_traceIndex.clear();
+        m_traceValue.clear();
+        m_tracePos.assign(m_weightSet->GetNumFeatures(), -1);
+    }
     ClearEligibility();
 }
 
 void RlTDLambda::Learn()
 {
-    RlWeight::EnsureEligibility();
-
     CalcDelta();
     CalcLogisticGradient();
     CalcStepSize();
@@ -114,95 +120,117 @@ void RlTDLambda::Learn()
 
     // Main TD-lambda update
     DecayEligibility();
-    for (RlActiveSet::Iterator i_active(m_oldState->Active()); 
-        i_active; ++i_active)
-    {
-        RlOccur occur = i_active->m_occurrences;
-        RlWeight& weight = 
-            m_weightSet->Get(i_active->m_featureIndex);
-        UpdateActive(weight, occur);
-    }
+    const RlActiveSnapshot& active = m_oldState->Active();
+    const int* indices = active.GetIndices();
+    const RlOccur* occurrences = active.GetOccurrences();
+    for (int i = 0; i < active.NumOccupied(); ++i)
+        UpdateActive(indices[i], occurrences[i]);
     UpdateEligible();
 }
 
+RlFloat RlTDLambda::GetEligibility(int featureindex) const
+{
+    if (featureindex >= ssize(m_tracePos) || m_tracePos[featureindex] < 0)
+        return 0;
+    return m_traceValue[m_tracePos[featureindex]] * m_scale;
+}
+
 void RlTDLambda::ClearEligibility()
 {
-    list<RlWeight*>::iterator i_nonZero = m_nonZero.begin();
-    while (i_nonZero != m_nonZero.end())
-    {
-        RlWeight* weight = *i_nonZero;
-        SG_ASSERT(weight->Active());
-        
-        weight->Eligibility() = 0;
-        weight->Active() = false;
-        i_nonZero = m_nonZero.erase(i_nonZero);
-    }
+    for (vector<int>::iterator i_trace = m_traceIndex.begin();
+        i_trace != m_traceIndex.end(); ++i_trace)
+        m_tracePos[*i_trace] = -1;
+    m_traceIndex.clear();
+    m_traceValue.clear();
+    m_scale = 1;
 }
 
 void RlTDLambda::DecayEligibility()
 {
     // Decay eligibility by lambda (recency weighting)
-    list<RlWeight*>::iterator i_nonZero = m_nonZero.begin();
-    while (i_nonZero != m_nonZero.end())
+    // Eligibilities that are almost zero are removed by UpdateEligible
+    m_scale *= m_lambda;
+    if (m_scale < s_minScale)
+        Renormalise();
+}
+
+void RlTDLambda::Renormalise()
+{
+    for (vector<RlFloat>::iterator i_value = m_traceValue.begin();
+        i_value != m_traceValue.end(); ++i_value)
+        *i_value *= m_scale;
+    m_scale = 1;
+}
+
+void RlTDLambda::RemoveTrace(int pos)
+{
+    // Move last trace into the vacated position
+    m_tracePos[m_traceIndex[pos]] = -1;
+    if (pos != ssize(m_traceIndex) - 1)
     {
-        RlWeight* weight = *i_nonZero;
-        SG_ASSERT(weight->Active());
-        
-        weight->Eligibility() *= m_lambda;
-        
-        // Deactivate any eligibilities that are almost zero
-        if (fabs(weight->Eligibility()) <= m_zeroThreshold)
-        {
-            i_nonZero = m_nonZero.erase(i_nonZero);
-            weight->Eligibility() = 0;
-            weight->Active() = false;
-        }
-        else
-        {
-            ++i_nonZero;
-        }
+        m_traceIndex[pos] = m_traceIndex.back();
+        m_traceValue[pos] = m_traceValue.back();
+        m_tracePos[m_traceIndex[pos]] = pos;
     }
+    m_traceIndex.pop_back();
+    m_traceValue.pop_back();
 }
 
-void RlTDLambda::UpdateActive(RlWeight& weight, RlOccur occurrences)
+void RlTDLambda::UpdateActive(int featureindex, RlOccur occurrences)
 {
     SG_ASSERT(occurrences > 0);
-    if (m_replacing)
-        weight.Eligibility() = 0;
-    weight.Eligibility() += occurrences;
-    weight.IncCount();
-    SANITY_CHECK(weight.Eligibility(), 
-        RlWeight::MIN_WEIGHT, RlWeight::MAX_WEIGHT);
-    
+    int pos = m_tracePos[featureindex];
+
+    // Eligibilities that have decayed to almost zero restart from zero
+    RlFloat eligibility = 0;
+    if (pos >= 0 && !m_replacing)
+    {
+        eligibility = m_traceValue[pos] * m_scale;
+        if (fabs(eligibility) <= m_zeroThreshold)
+            eligibility = 0;
+    }
+    eligibility += occurrences;
+    m_weightSet->Get(featureindex).IncCount();
+    SANITY_CHECK(eligibility, RlWeight::MIN_WEIGHT, RlWeight::MAX_WEIGHT);
+
     // Activate eligibility if not already
-    if (!weight.Active() && fabs(weight.Eligibility()) > m_zeroThreshold)
+    if (pos >= 0)
+        m_traceValue[pos] = eligibility / m_scale;
+    else if (fabs(eligibility) > m_zeroThreshold)
     {
-        m_nonZero.push_back(&weight);
-        weight.Active() = true;
+        m_tracePos[featureindex] = m_traceIndex.size();
+        m_traceIndex.push_back(featureindex);
+        m_traceValue.push_back(eligibility / m_scale);
     }
 }
 
 void RlTDLambda::UpdateEligible()
 {
     // Update weights for all non-zero eligibility traces
-    for (list<RlWeight*>::iterator i_nonZero = m_nonZero.begin(); 
-        i_nonZero != m_nonZero.end(); ++i_nonZero)
+    int pos = 0;
+    while (pos < ssize(m_traceIndex))
     {
-        RlWeight* weight = *i_nonZero;
-        SG_ASSERT(weight->Active());
-        UpdateWeight(*weight);
+        RlFloat eligibility = m_traceValue[pos] * m_scale;
+        if (fabs(eligibility) <= m_zeroThreshold)
+        {
+            RemoveTrace(pos);
+            continue;
+        }
+        RlWeight weight = m_weightSet->Get(m_traceIndex[pos]);
+        UpdateWeight(weight, eligibility);
+        ++pos;
     }
 }
 
-inline void RlTDLambda::UpdateWeight(RlWeight& weight)
+inline void RlTDLambda::UpdateWeight(RlWeight& weight, RlFloat eligibility)
 {    
     if (!CheckOnPolicy())
         return;
 
-    RlFloat update = m_stepSize * m_delta * weight.Eligibility();
+    RlFloat update = m_stepSize * m_delta * eligibility;
     if (m_mse)
         update *= m_logisticGradient;
-    weight.Weight() += update;
+    weight.AddWeight(update);
 
     SANITY_CHECK(weight.Weight(), RlWeight::MIN_WEIGHT, RlWeight::MAX_WEIGHT);
 
@@ -55,7 +55,11 @@ private:
 };
 
 //----------------------------------------------------------------------------
-/** TD(lambda) algorithm */
+/** TD(lambda) algorithm.
+    Non-zero eligibility traces are kept in dense arrays, separately from
+    the weights. Traces are stored relative to a global scale factor, so
+    that decaying all traces by lambda is a single multiplication. The 
+    stored traces are renormalised when the scale factor becomes small. */
 class RlTDLambda : public RlTD0
 {
 public:
@@ -73,6 +77,9 @@ public:
     
     /** Update all weights (must set data first) */
     virtual void Learn();
+
+    /** Current eligibility trace of a feature */
+    virtual RlFloat GetEligibility(int featureindex) const;
     
     /** TD(lambda) can only operate with forwards execution */
     virtual bool IsForwards() const { return true; }
@@ -87,20 +94,41 @@ protected:
     void DecayEligibility();
 
     /** Update eligibility for an active feature */
-    void UpdateActive(RlWeight& weight, RlOccur occurrences);
+    void UpdateActive(int featureindex, RlOccur occurrences);
 
-    /** Update weights for all features with non-zero eligibilities */
+    /** Update weights for all features with non-zero eligibilities,
+        and remove eligibilities that have decayed to almost zero */
     void UpdateEligible();
     
     /** Update a single weight */
-    void UpdateWeight(RlWeight& weight);
+    void UpdateWeight(RlWeight& weight, RlFloat eligibility);
+
+    /** Fold the scale factor into the stored traces */
+    void Renormalise();
+
+    /** Remove trace at specified position in the dense arrays */
+    void RemoveTrace(int pos);
 
 private:
 
     RlFloat m_lambda;
     bool m_replacing;
     RlFloat m_zeroThreshold;
-    std::list<RlWeight*> m_nonZero;
+
+    /** Feature indices of non-zero traces */
+    std::vector<int> m_traceIndex;
+
+    /** Non-zero traces, divided by the scale factor */
+    std::vector<RlFloat> m_traceValue;
+
+    /** Position of each feature in the dense arrays, or -1 */
+    std::vector<int> m_tracePos;
+
+    /** Scale factor applied to all stored traces */
+    RlFloat m_scale;
+
+    /** Renormalise when the scale factor falls below this value */
+    static const RlFloat s_minScale;
 };
 
 //----------------------------------------------------------------------------
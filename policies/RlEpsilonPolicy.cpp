@@ -7,6 +7,8 @@
 #include "SgSystem.h"
 #include "RlEpsilonPolicy.h"
 
+#include "RlRandomUtil.h"
+
 using namespace std;
 
 //----------------------------------------------------------------------------
@@ -33,7 +35,7 @@ void RlEpsilonPolicy::LoadSettings(istream& settings)
 
 SgMove RlEpsilonPolicy::SelectMove(RlState& state)
 {
-    bool explore = SgRandomFloat(0.0f, 1.0) < m_epsilon;
+    bool explore = RlRandomUtil::Float(0.0f, 1.0) < m_epsilon;
 
     SgMove move = SG_NULLMOVE;
     if (explore)
@@ -76,7 +78,7 @@ void RlEpsilonDecayPolicy::Initialise()
 SgMove RlEpsilonDecayPolicy::SelectMove(RlState& state)
 {
     RlFloat prob = powf(1 - m_epsilon, state.TimeStep() + 1);
-    bool explore = SgRandomFloat(0.0f, 1.0) > prob;
+    bool explore = RlRandomUtil::Float(0.0f, 1.0) > prob;
 
     SgMove move;
     if (explore)
@@ -11,10 +11,13 @@
 #include "RlLogger.h"
 #include "RlMoveFilter.h"
 #include "RlMoveUtil.h"
+#include "RlRandomUtil.h"
+#include "RlSimdUtil.h"
 
 using namespace std;
 using namespace RlMathUtil;
 using namespace RlMoveUtil;
+using namespace RlShapeUtil;
 
 //----------------------------------------------------------------------------
 
@@ -25,26 +28,58 @@ RlGibbs::RlGibbs(GoBoard& board, RlEvaluator* evaluator, RlLogger* log,
 :   RlPolicy(board, evaluator, log),
     m_temperature(temperature),
     m_centre(true),
-    m_redraw(false)
+    m_redraw(false),
+    m_incremental(false),
+    m_lastColour(0)
 { 
+    for (int c = 0; c < 2; ++c)
+    {
+        m_epoch[c] = -1;
+        m_position[c] = 0;
+        m_reference[c] = 0;
+    }
 }
 
 void RlGibbs::LoadSettings(istream& settings)
 {
-    RlPolicy::LoadSettings(settings);
+    // Versions 1 and 2 are the policy versions (see RlPolicy::LoadSettings)
+    int version;
+    settings >> RlVersion(version, 3, 1);
+    settings >> RlSetting<RlEvaluator*>("Evaluator", m_evaluator);
+    if (version >= 2)
+        settings >> RlSetting<RlLogger*>("Log", m_log);
+    settings >> RlSetting<bool>("OnPolicy", m_onPolicy);
     settings >> RlSetting<RlFloat>("Temperature", m_temperature);
     settings >> RlSetting<bool>("Centre", m_centre);
     settings >> RlSetting<bool>("Redraw", m_redraw);
+    if (version >= 3)
+        settings >> RlSetting<bool>("Incremental", m_incremental);
 }
 
 void RlGibbs::Initialise()
 {
     RlPolicy::Initialise();
     m_moveIndices.resize(SG_MAXPOINT + 2); // include pass move
+    if (m_incremental)
+    {
+        if (!m_evaluator->UseDifferences())
+            throw SgException("Incremental Gibbs requires differences");
+        for (int c = 0; c < 2; ++c)
+        {
+            m_tree[c].Resize(SG_PASS + 1);
+            m_pending[c].reserve(SG_PASS + 1);
+            for (int i = 0; i <= SG_PASS; ++i)
+                m_isPending[c][i] = false;
+        }
+        m_recheck.reserve(SG_PASS + 1);
+    }
 }
 
 SgMove RlGibbs::SelectMove(RlState& state)
 {
+    if (m_incremental)
+        return SelectIncremental(state);
+
     // Allow multiple samples to be redrawn without recalculating distribution
     bool redraw = m_redraw && state.PolicyType() == RlState::POL_BEST;
     if (!redraw)
@@ -83,7 +118,6 @@ void RlGibbs::EvaluateMoves(RlState& state)
         RlFloat eval = m_evaluator->EvaluateMove(move, state.Colour());
         SANITY_CHECK(eval, -RlInfinity, +RlInfinity);
         m_evals.push_back(eval);
-        m_values.push_back(Logistic(eval));
         m_moveIndices[m_moves[m]] = m;
     }
 
@@ -94,8 +128,11 @@ void RlGibbs::EvaluateMoves(RlState& state)
     {
         m_evals.back() = state.Colour() == SG_BLACK 
             ? -RL_MAX_EVAL : +RL_MAX_EVAL;
-        m_values.back() = Logistic(m_evals.back());
     }
+
+    m_values.resize(m_evals.size());
+    if (!m_evals.empty())
+        RlSimdUtil::Logistic(&m_evals[0], &m_values[0], m_evals.size());
 }
 
 void RlGibbs::MakeGibbs(bool negate)
@@ -117,20 +154,14 @@ void RlGibbs::MakeGibbs(bool negate)
         mean /= size;
     }
     
-    RlFloat z = 0;
     for (int i = 0; i < size; ++i)
     {
-        RlFloat exponent = (sign * m_evals[i] - mean) / m_temperature;
-        if (exponent > emax)
+        m_probs[i] = (sign * m_evals[i] - mean) / m_temperature;
+        if (m_probs[i] > emax)
         {
-            emax = exponent;
+            emax = m_probs[i];
             imax = i;
         }
-        else
-        {
-            m_probs[i] = exp(exponent);
-            z += m_probs[i];
-        }
     }
     
     // If values are too high for exp, set probabilities to argmax
@@ -144,6 +175,10 @@ void RlGibbs::MakeGibbs(bool negate)
     // Otherwise normalise to give total probability of 1
     else
     {
+        RlSimdUtil::Exp(&m_probs[0], &m_probs[0], size);
+        RlFloat z = 0;
+        for (int i = 0; i < size; ++i)
+            z += m_probs[i];
         RlFloat normaliser = 1.0 / z;
         for (int i = 0; i < size; ++i)
             m_probs[i] *= normaliser;
@@ -154,8 +189,166 @@ void RlGibbs::MakeGibbs(bool negate)
     m_statDeterministic.Add(imax >= 0 ? 1.0 : 0.0);
 }
 
+SgMove RlGibbs::SelectIncremental(RlState& state)
+{
+    SgBlackWhite colour = state.Colour();
+    int c = BWIndex(colour);
+    m_lastColour = c;
+    UpdateTree(colour);
+    state.SetPolicyType(RlState::POL_BEST);
+
+    // Moves can become disallowed without being journalled, e.g. by ko 
+    // or by filters that depend on the last move. These are only detected
+    // when sampled, and then removed until they are allowed again.
+    RlSumTree& tree = m_tree[c];
+    while (tree.Total() > 0)
+    {
+        SgMove move = tree.Find(RlRandomUtil::Float(0, tree.Total()));
+        if (tree.Get(move) > 0 && IsAllowed(move, colour))
+        {
+            LogPolicy(state, move);
+            return move;
+        }
+        if (tree.Get(move) > 0)
+            RefreshMove(colour, move);
+        else
+            tree.Rebuild(); // rounding errors in partial sums
+    }
+    return SG_PASS;
+}
+
+void RlGibbs::UpdateTree(SgBlackWhite colour)
+{
+    int c = BWIndex(colour);
+    const RlDirtySet& dirty = m_evaluator->GetDirtySet();
+    if (dirty.GetEpoch() != m_epoch[c])
+    {
+        RebuildTree(colour);
+        return;
+    }
+
+    // Points that were not allowed may have become allowed
+    m_recheck.swap(m_pending[c]);
+    m_pending[c].clear();
+    for (int i = 0; i < ssize(m_recheck); ++i)
+        m_isPending[c][m_recheck[i]] = false;
+    for (int i = 0; i < ssize(m_recheck); ++i)
+        if (!RefreshMove(colour, m_recheck[i]))
+        {
+            RebuildTree(colour);
+            return;
+        }
+    
+    // Only moves in the journal have changed value or occupancy
+    int size = dirty.GetJournalSize(colour);
+    for (int i = m_position[c]; i < size; ++i)
+        if (!RefreshMove(colour, dirty.GetJournalMove(colour, i)))
+        {
+            RebuildTree(colour);
+            return;
+        }
+    if (!RefreshMove(colour, SG_PASS))
+    {
+        RebuildTree(colour);
+        return;
+    }
+    m_position[c] = size;
+}
+
+void RlGibbs::RebuildTree(SgBlackWhite colour)
+{
+    int c = BWIndex(colour);
+    RlSumTree& tree = m_tree[c];
+    for (int i = 0; i < ssize(m_pending[c]); ++i)
+        m_isPending[c][m_pending[c][i]] = false;
+    m_pending[c].clear();
+
+    // Use the largest exponent as reference, so that all weights are <= 1
+    const RlFloat unset = -RlInfinity;
+    RlFloat maxexponent = unset;
+    m_exponents.assign(SG_PASS + 1, unset);
+    for (GoBoard::Iterator i_board(m_board); i_board; ++i_board)
+    {
+        SgMove move = *i_board;
+        if (IsAllowed(move, colour))
+            m_exponents[move] = GetExponent(move, colour);
+        else if (m_board.IsEmpty(move))
+        {
+            m_pending[c].push_back(move);
+            m_isPending[c][move] = true;
+        }
+    }
+    if (IsAllowed(SG_PASS, colour))
+        m_exponents[SG_PASS] = GetExponent(SG_PASS, colour);
+    for (SgMove move = 0; move <= SG_PASS; ++move)
+        if (m_exponents[move] > maxexponent)
+            maxexponent = m_exponents[move];
+    m_reference[c] = maxexponent == unset ? 0 : maxexponent;
+
+    // Points off the board always keep zero weight
+    for (GoBoard::Iterator i_board(m_board); i_board; ++i_board)
+    {
+        SgMove move = *i_board;
+        tree.Set(move, m_exponents[move] == unset 
+            ? 0 : RlSimdUtil::Exp(m_exponents[move] - m_reference[c]));
+    }
+    tree.Set(SG_PASS, m_exponents[SG_PASS] == unset 
+        ? 0 : RlSimdUtil::Exp(m_exponents[SG_PASS] - m_reference[c]));
+    tree.Rebuild();
+    
+    const RlDirtySet& dirty = m_evaluator->GetDirtySet();
+    m_epoch[c] = dirty.GetEpoch();
+    m_position[c] = dirty.GetJournalSize(colour);
+}
+
+bool RlGibbs::RefreshMove(SgBlackWhite colour, SgMove move)
+{
+    const RlFloat maxexp = 50;
+    int c = BWIndex(colour);
+    RlFloat weight = 0;
+    if (IsAllowed(move, colour))
+    {
+        RlFloat exponent = GetExponent(move, colour) - m_reference[c];
+        if (exponent > maxexp)
+            return false;
+        weight = RlSimdUtil::Exp(exponent);
+    }
+    else if (move != SG_PASS && m_board.IsEmpty(move) 
+        && !m_isPending[c][move])
+    {
+        m_pending[c].push_back(move);
+        m_isPending[c][move] = true;
+    }
+    m_tree[c].Set(move, weight);
+    return true;
+}
+
+inline bool RlGibbs::IsAllowed(SgMove move, SgBlackWhite colour) const
+{
+    const RlMoveFilter* filter = m_evaluator->GetMoveFilter();
+    if (move == SG_PASS)
+        return filter->ConsiderPass();
+    return m_board.IsEmpty(move) && filter->ConsiderMove(move, colour);
+}
+
+inline RlFloat RlGibbs::GetExponent(SgMove move, SgBlackWhite colour)
+{
+    // The current evaluation is common to all moves and cancels out in the
+    // distribution, so only the cached differences are used
+    RlFloat sign = colour == SG_WHITE ? -1.0 : +1.0;
+    RlFloat diff = m_evaluator->EvaluateMove(move, colour) 
+        - m_evaluator->Eval();
+    return sign * diff / m_temperature;
+}
+
 RlFloat RlGibbs::GetProbability(SgMove move) const
 {
+    if (m_incremental)
+    {
+        const RlSumTree& tree = m_tree[m_lastColour];
+        return tree.Total() > 0 ? tree.Get(move) / tree.Total() : 0.0;
+    }
+
     int moveindex = m_moveIndices[move];
     if (moveindex < 0)
         return 0.0;
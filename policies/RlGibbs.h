@@ -8,9 +8,14 @@
 #define RLGIBBS_H
 
 #include "RlPolicy.h"
+#include "RlSumTree.h"
 
 //----------------------------------------------------------------------------
-/** Select move according to Gibbs distribution */
+/** Select move according to Gibbs distribution.
+    In incremental mode, unnormalised probabilities are kept in a sum tree
+    for each colour. Only moves in the evaluator's journal of dirty moves
+    are re-evaluated, and sampling takes O(log n). This requires an 
+    evaluator that uses differences. */
 class RlGibbs : public RlPolicy
 {
 public:
@@ -48,6 +53,25 @@ protected:
 
     /** Log any info for this policy */
     virtual void LogPolicy(const RlState& state, SgBlackWhite move);
+
+    /** Sample a move from the incremental distribution */
+    SgMove SelectIncremental(RlState& state);
+
+    /** Bring sum tree up to date with the evaluator's dirty journal */
+    void UpdateTree(SgBlackWhite colour);
+
+    /** Evaluate all moves and rebuild sum tree */
+    void RebuildTree(SgBlackWhite colour);
+
+    /** Re-evaluate a single move in the sum tree.
+        Returns false if the weight is too large for the current reference */
+    bool RefreshMove(SgBlackWhite colour, SgMove move);
+
+    /** Whether move should be included in the distribution */
+    bool IsAllowed(SgMove move, SgBlackWhite colour) const;
+
+    /** Exponent of unnormalised probability, from difference to evaluation */
+    RlFloat GetExponent(SgMove move, SgBlackWhite colour);
     
 private:
 
@@ -62,6 +86,28 @@ private:
     std::vector<RlFloat> m_values;
     std::vector<RlChangeList> m_changeLists;
     std::vector<int> m_moveIndices;
+
+    /** Whether to update the distribution incrementally */
+    bool m_incremental;
+
+    /** Unnormalised probabilities of all moves, for each colour */
+    RlSumTree m_tree[2];
+
+    /** Exponent corresponding to a weight of 1 in each sum tree */
+    RlFloat m_reference[2];
+
+    /** Dirty journal epoch and position that each sum tree reflects */
+    int m_epoch[2];
+    int m_position[2];
+
+    /** Vacant points that were not allowed when last refreshed */
+    std::vector<SgMove> m_pending[2];
+    bool m_isPending[2][SG_PASS + 1];
+    std::vector<SgMove> m_recheck;
+    std::vector<RlFloat> m_exponents;
+
+    /** Colour of the most recent incremental selection */
+    int m_lastColour;
     
     /** Debugging statistics */
     RlStat m_statMean;
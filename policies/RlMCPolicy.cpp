@@ -36,7 +36,7 @@ SgMove RlMCPolicy::SelectMove(RlState& state)
     //@todo: could be more efficient by ordering moves (e.g. killer first)
     // and then cutting off when max wins can't be exceeded.
 
-    static vector<SgMove> moves;
+    vector<SgMove> moves;
     m_evaluator->GetMoveFilter()->GetMoveVector(state.Colour(), moves);
     SgBlackWhite toplay = m_board.ToPlay();
     RlFloat bestvalue = toplay == SG_BLACK ? -RlInfinity : +RlInfinity;
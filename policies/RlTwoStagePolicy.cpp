@@ -7,6 +7,7 @@
 #include "SgSystem.h"
 #include "RlTwoStagePolicy.h"
 
+#include "RlRandomUtil.h"
 #include "RlSimulator.h"
 
 using namespace std;
@@ -41,7 +42,7 @@ SgMove RlTwoStagePolicy::SelectMove(RlState& state)
 
     SgMove move;
     if (state.TimeStep() < floor
-        || (state.TimeStep() == floor && SgRandomFloat(0.0f, 1.0) < p))
+        || (state.TimeStep() == floor && RlRandomUtil::Float(0.0f, 1.0) < p))
     {
         move = m_policy1->SelectMove(state);
     }
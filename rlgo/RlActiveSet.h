@@ -84,14 +84,30 @@ public:
         if (m_numChanges == m_capacity)
         {
             m_changes.push_back(change);
+            m_indices.push_back(change.m_featureIndex);
+            m_occurrences.push_back(change.m_occurrences);
             m_capacity++;
         }
         else
         {
             m_changes[m_numChanges] = change;
+            m_indices[m_numChanges] = change.m_featureIndex;
+            m_occurrences[m_numChanges] = change.m_occurrences;
         }
         m_numChanges++;
     }
+
+    /** Packed array of changed feature indices, for gather kernels */
+    const int* GetIndices() const
+    {
+        return m_indices.empty() ? 0 : &m_indices[0];
+    }
+
+    /** Packed array of changed occurrences, parallel to GetIndices() */
+    const RlOccur* GetOccurrences() const
+    {
+        return m_occurrences.empty() ? 0 : &m_occurrences[0];
+    }
     
     void CopyList(const RlChangeList& changelist)
     {
@@ -199,12 +215,17 @@ private:
     int m_capacity;
     int m_numChanges;
     std::vector<RlChange> m_changes;
+    std::vector<int> m_indices;
+    std::vector<RlOccur> m_occurrences;
     
 friend class Iterator;
 };
 
 //----------------------------------------------------------------------------
-/** A set of feature indices that is active at any time */
+/** A set of feature indices that is active at any time.
+    Occupied slots are also kept in a compact list, with an index from slot 
+    to position in the list, so that iteration is proportional to the 
+    number of active slots rather than the total number of slots. */
 class RlActiveSet
 {
 public:
@@ -213,6 +234,7 @@ public:
     :   m_totalActive(0)
     {
         m_entries.resize(size);
+        m_position.resize(size, -1);
     }
 
     int Size() const 
@@ -220,16 +242,33 @@ public:
         return m_entries.size(); 
     }
 
+    /** Number of occupied slots */
+    int NumOccupied() const
+    {
+        return m_occupied.size();
+    }
+
     void Resize(int size)
     {
-        m_entries.resize(size);
         Clear();
+        m_entries.resize(size);
+        m_position.resize(size, -1);
+        m_occupied.reserve(size);
+        m_packedIndices.reserve(size);
+        m_packedOccurrences.reserve(size);
     }
 
     void Clear()
     {
-        for (int i = 0; i < Size(); ++i)
-            m_entries[i].Clear();
+        for (std::vector<int>::iterator i_slot = m_occupied.begin();
+            i_slot != m_occupied.end(); ++i_slot)
+        {
+            m_entries[*i_slot].Clear();
+            m_position[*i_slot] = -1;
+        }
+        m_occupied.clear();
+        m_packedIndices.clear();
+        m_packedOccurrences.clear();
         m_totalActive = 0;
     }
     
@@ -246,9 +285,39 @@ public:
         m_totalActive += change.m_occurrences;
         entry.m_occurrences += change.m_occurrences;
         if (entry.m_occurrences == 0)
+        {
+            if (entry.m_featureIndex != -1)
+                RemoveSlot(change.m_slot);
             entry.m_featureIndex = -1;
+        }
         else
+        {
             entry.m_featureIndex = change.m_featureIndex;
+            if (m_position[change.m_slot] == -1)
+                AddSlot(change.m_slot);
+            else
+                m_packedOccurrences[m_position[change.m_slot]] 
+                    = entry.m_occurrences;
+        }
+    }
+
+    /** Packed array of active feature indices, for gather kernels.
+        Parallel to the occupied slots, in iteration order. */
+    const int* GetIndices() const
+    {
+        return m_packedIndices.empty() ? 0 : &m_packedIndices[0];
+    }
+
+    /** Packed array of active occurrences, parallel to GetIndices() */
+    const RlOccur* GetOccurrences() const
+    {
+        return m_packedOccurrences.empty() ? 0 : &m_packedOccurrences[0];
+    }
+
+    /** Packed array of occupied slots, parallel to GetIndices() */
+    const int* GetSlots() const
+    {
+        return m_occupied.empty() ? 0 : &m_occupied[0];
     }
     
     bool IsActive(int slot) const
@@ -282,62 +351,207 @@ public:
         }
     }
 
+    /** Iterate over occupied slots (in no particular order) */
     class Iterator
     {
     public:
 
-        Iterator(const RlActiveSet& active, int startslot = 0)
+        Iterator(const RlActiveSet& active)
         :   m_active(active),
-            m_cursor(startslot)
+            m_cursor(0)
         { 
-            SkipEmpty();
         }
         
         const RlActiveEntry& operator*()
         {
-            return m_active.m_entries[m_cursor];
+            return m_active.m_entries[Slot()];
         }
 
         const RlActiveEntry* operator->()
         {
-            return &m_active.m_entries[m_cursor];
+            return &m_active.m_entries[Slot()];
         }
 
         void operator++()
         {
             ++m_cursor;
-            SkipEmpty();
         }
 
         operator bool() const
         {
-            return m_cursor < m_active.Size();
+            return m_cursor < m_active.NumOccupied();
         }
         
         int Slot() const
         {
-            return m_cursor;
+            return m_active.m_occupied[m_cursor];
         }
         
     private:
 
-        void SkipEmpty()
+        const RlActiveSet& m_active;
+        int m_cursor;
+    };
+
+protected:
+
+    void AddSlot(int slot)
+    {
+        SG_ASSERT(m_position[slot] == -1);
+        m_position[slot] = m_occupied.size();
+        m_occupied.push_back(slot);
+        m_packedIndices.push_back(m_entries[slot].m_featureIndex);
+        m_packedOccurrences.push_back(m_entries[slot].m_occurrences);
+    }
+
+    void RemoveSlot(int slot)
+    {
+        // Move last occupied slot into the vacated position
+        int pos = m_position[slot];
+        SG_ASSERT(pos >= 0 && m_occupied[pos] == slot);
+        int last = m_occupied.back();
+        m_occupied[pos] = last;
+        m_packedIndices[pos] = m_packedIndices.back();
+        m_packedOccurrences[pos] = m_packedOccurrences.back();
+        m_position[last] = pos;
+        m_occupied.pop_back();
+        m_packedIndices.pop_back();
+        m_packedOccurrences.pop_back();
+        m_position[slot] = -1;
+    }
+    
+    std::vector<RlActiveEntry> m_entries;
+    RlOccur m_totalActive;
+
+    /** Compact list of occupied slots */
+    std::vector<int> m_occupied;
+
+    /** Position of each slot in occupied list, or -1 if unoccupied */
+    std::vector<int> m_position;
+
+    /** Feature indices and occurrences of occupied slots, 
+        packed in the same order as the occupied list */
+    std::vector<int> m_packedIndices;
+    std::vector<RlOccur> m_packedOccurrences;
+
+friend class Iterator;
+};
+
+//----------------------------------------------------------------------------
+/** Compact copy of the active features in an active set.
+    Only the occupied slots are stored, so memory is proportional to the
+    number of active features rather than the total number of slots.
+    Storage is reused when a snapshot is overwritten. */
+class RlActiveSnapshot
+{
+public:
+
+    RlActiveSnapshot()
+    :   m_totalActive(0)
+    {
+    }
+
+    /** Copy the occupied slots of an active set */
+    void Copy(const RlActiveSet& active)
+    {
+        int n = active.NumOccupied();
+        m_indices.assign(active.GetIndices(), active.GetIndices() + n);
+        m_occurrences.assign(active.GetOccurrences(), 
+            active.GetOccurrences() + n);
+        m_slots.assign(active.GetSlots(), active.GetSlots() + n);
+        m_totalActive = active.GetTotalActive();
+    }
+
+    void Clear()
+    {
+        m_indices.clear();
+        m_occurrences.clear();
+        m_slots.clear();
+        m_totalActive = 0;
+    }
+
+    /** Number of occupied slots */
+    int NumOccupied() const
+    {
+        return m_indices.size();
+    }
+
+    /** Packed array of active feature indices, for gather kernels */
+    const int* GetIndices() const
+    {
+        return m_indices.empty() ? 0 : &m_indices[0];
+    }
+
+    /** Packed array of active occurrences, parallel to GetIndices() */
+    const RlOccur* GetOccurrences() const
+    {
+        return m_occurrences.empty() ? 0 : &m_occurrences[0];
+    }
+
+    RlOccur GetTotalActive() const
+    {
+        return m_totalActive;
+    }
+
+    /** Iterate over occupied slots, in the order of the active set */
+    class Iterator
+    {
+    public:
+
+        Iterator(const RlActiveSnapshot& snapshot)
+        :   m_snapshot(snapshot),
+            m_cursor(0)
+        {
+            Fetch();
+        }
+
+        const RlActiveEntry& operator*() const
+        {
+            return m_entry;
+        }
+
+        const RlActiveEntry* operator->() const
+        {
+            return &m_entry;
+        }
+
+        void operator++()
+        {
+            ++m_cursor;
+            Fetch();
+        }
+
+        operator bool() const
+        {
+            return m_cursor < m_snapshot.NumOccupied();
+        }
+
+        int Slot() const
+        {
+            return m_snapshot.m_slots[m_cursor];
+        }
+
+    private:
+
+        void Fetch()
         {
-            while (m_cursor < m_active.Size()
-                && m_active.m_entries[m_cursor].m_featureIndex == -1)
+            if (*this)
             {
-                ++m_cursor;
+                m_entry.m_featureIndex = m_snapshot.m_indices[m_cursor];
+                m_entry.m_occurrences = m_snapshot.m_occurrences[m_cursor];
             }
         }
-        
 
-        const RlActiveSet& m_active;
+        const RlActiveSnapshot& m_snapshot;
         int m_cursor;
+        RlActiveEntry m_entry;
     };
 
-protected:
-    
-    std::vector<RlActiveEntry> m_entries;
+private:
+
+    std::vector<int> m_indices;
+    std::vector<RlOccur> m_occurrences;
+    std::vector<int> m_slots;
     RlOccur m_totalActive;
 
 friend class Iterator;
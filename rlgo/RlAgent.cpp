@@ -15,6 +15,7 @@
 #include "RlMoveFilter.h"
 #include "RlPolicy.h"
 #include "RlSetup.h"
+#include "RlSimdUtil.h"
 #include "RlSimulator.h"
 #include "RlTrace.h"
 #include "RlTrainer.h"
@@ -87,7 +88,7 @@ void RlAgent::Initialise()
     if (m_tester)
         m_tester->EnsureInitialised();
 
-    m_history->Resize(m_evaluator->GetActiveSize());
+    m_history->Allocate();
 }
 
 void RlAgent::NewGame()
@@ -240,7 +241,7 @@ RlFloat RlAgent::GetProbability(SgMove move, SgBlackWhite colour) const
 
     if (m_board.ToPlay() == SG_WHITE)
         value = -value;
-    return Logistic(value);
+    return RlSimdUtil::Logistic(value);
 }
 
 bool RlAgent::CheckResign(RlFloat pwin) const
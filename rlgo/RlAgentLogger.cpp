@@ -16,6 +16,7 @@
 #include "RlSetup.h"
 #include "RlSimulator.h"
 #include "RlTrace.h"
+#include "RlTrainer.h"
 #include "GoGame.h"
 #include "SgGameWriter.h"
 #include "SgPointSetUtil.h"
@@ -87,9 +88,7 @@ void RlAgentLogger::InitLogs()
 void RlAgentLogger::AddItems()
 {
     m_featureTrace->AddLog("Weight");
-#ifdef RL_ELIGIBILITY
     m_featureTrace->AddLog("Eligibility");
-#endif
 #ifdef RL_COUNT
     m_featureTrace->AddLog("Count");
 #endif
@@ -144,10 +143,10 @@ void RlAgentLogger::LogWeights()
         RlWeightSet* wset = m_agent->GetWeightSet();
         (*m_featureTrace)["Weight"]->Log(featureindex, 
             wset->Get(featureindex).Weight());
-#ifdef RL_ELIGIBILITY
+        RlTrainer* trainer = m_agent->GetTrainer();
         (*m_featureTrace)["Eligibility"]->Log(featureindex, 
-            wset->Get(featureindex).Eligibility());
-#endif
+            trainer && trainer->GetLearningRule() 
+            ? trainer->GetLearningRule()->GetEligibility(featureindex) : 0);
 #ifdef RL_COUNT
         (*m_featureTrace)["Count"]->Log(featureindex, 
             wset->Get(featureindex).Count());
@@ -220,7 +219,7 @@ void RlAgentLogger::LogEvalMove(SgMove move)
         << " = " << eval << ":\n";
     for (RlChangeList::Iterator i_changes(changelist); i_changes; ++i_changes)
     {
-        RlWeight& weight = wset->Get(i_changes->m_featureIndex);
+        RlWeight weight = wset->Get(i_changes->m_featureIndex);
         m_agent->GetFeatureSet()->DescribeFeature(
             i_changes->m_featureIndex, Debug(RlSetup::VERBOSE));
         Debug(RlSetup::VERBOSE) 
@@ -252,10 +251,10 @@ void RlAgentLogger::PrintValue()
 
     Debug(RlSetup::VERBOSE) << "Active features:\n";
     RlWeightSet* wset = m_agent->GetWeightSet();
-    for (RlActiveSet::Iterator i_active(state.Active()); 
+    for (RlActiveSnapshot::Iterator i_active(state.Active()); 
         i_active; ++i_active)
     {
-        RlWeight& weight = wset->Get(i_active->m_featureIndex);
+        RlWeight weight = wset->Get(i_active->m_featureIndex);
         m_agent->GetFeatureSet()->DescribeFeature(
             i_active->m_featureIndex, 
             Debug(RlSetup::VERBOSE));
@@ -9,6 +9,14 @@
 #include "RlMoveFilter.h"
 #include "RlSetup.h"
 
+#include <set>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+
+using namespace boost;
 using namespace GoBoardUtil;
 using namespace RlMoveUtil;
 using namespace std;
@@ -24,6 +32,7 @@ RlAlphaBeta::RlAlphaBeta(GoBoard& board, RlEvaluator* evaluator)
     m_maxTime(10),
     m_maxPredictedTime(RlInfinity),
     m_hashSize(0x100000),
+    m_largePages(false),
     m_sortDepth(2),
     m_historyHeuristic(true),
     m_killerHeuristic(true),
@@ -34,13 +43,23 @@ RlAlphaBeta::RlAlphaBeta(GoBoard& board, RlEvaluator* evaluator)
     m_maxExtensions(0),
     m_ensureParity(true),
     m_pvs(true),
-    m_branchPower(0.25)
+    m_branchPower(0.25),
+    m_numThreads(1),
+    m_hashTable(0),
+    m_numBuckets(0),
+    m_hashBytes(0),
+    m_hashMapped(false),
+    m_ownsHash(true),
+    m_generation(1),
+    m_stopHelpers(false),
+    m_stop(0)
 {
 }
 
 RlAlphaBeta::~RlAlphaBeta()
 {
-    delete [] m_hashTable;
+    if (m_ownsHash)
+        FreeHash();
 }
 
 void RlAlphaBeta::LoadSettings(istream& settings)
@@ -61,32 +80,140 @@ void RlAlphaBeta::LoadSettings(istream& settings)
     settings >> RlSetting<bool>("EnsureParity", m_ensureParity);
     settings >> RlSetting<bool>("PVS", m_pvs);
     settings >> RlSetting<RlFloat>("BranchPower", m_branchPower);
+    settings >> RlSetting<int>("NumThreads", m_numThreads);
+    settings >> RlSetting<bool>("LargePages", m_largePages);
 }
 
 void RlAlphaBeta::Initialise()
 {
     m_evaluator->EnsureInitialised();
-    m_hashTable = new HashEntry[m_hashSize];
+    SG_ASSERT(sizeof(HashBucket) == 64);
     SG_ASSERT(m_maxExtensions < 256);
+    SG_ASSERT(m_maxDepth + m_maxExtensions < 2048); // packed in 12 bits
     Clear();
 }
 
 RlFloat RlAlphaBeta::Search(vector<SgMove>& pv)
 {
     m_elapsedTime = 0;
+    if (!m_hashTable)
+        AllocateHash();
+    ResizeMoveStacks();
+    if (GetNumThreads() < m_numThreads)
+        CreateHelpers();
+
+    // Helpers search the same position independently and only communicate
+    // through the shared hash table. The result is taken from this thread.
+    thread_group threads;
+    StartHelpers(threads);
+    try
+    {
+        for (m_iterationDepth = 1; ; ++m_iterationDepth)
+        {
+            m_timer.Start();
+            ClearStatistics();
+            SortMoves(m_sortedMoves);
+            int eval = AlphaBeta(m_iterationDepth, 
+                -RL_SEARCH_MAX, +RL_SEARCH_MAX, 
+                0, 0, 0); // from toplay's point of view
+            PrincipalVariation(pv);
+            OutputStatistics(eval, pv, RlDebug(RlSetup::VOCAL));
+            if (CheckAbort())
+            {
+                StopHelpers(threads);
+                return FloatValue(eval); // from black's point of view
+            }
+        }
+    }
+    catch (...)
+    {
+        m_stopHelpers = true;
+        threads.join_all();
+        throw;
+    }
+}
+
+void RlAlphaBeta::CreateHelpers()
+{
+    RlFactory& factory = RlGetFactory();
+    string id = factory.GetID(this);
+    set<string> shared;
+    shared.insert(factory.GetID(m_evaluator->GetWeightSet()));
 
-    for (m_iterationDepth = 1; ; ++m_iterationDepth)
+    while (GetNumThreads() < m_numThreads)
     {
-        m_timer.Start();
-        ClearStatistics();
-        SortMoves(m_sortedMoves);
-        int eval = AlphaBeta(m_iterationDepth, 
-            -RL_SEARCH_MAX, +RL_SEARCH_MAX, 
-            0, 0, 0); // from toplay's point of view
-        PrincipalVariation(pv);
-        OutputStatistics(eval, pv, RlDebug(RlSetup::VOCAL));
-        if (CheckAbort())
-            return FloatValue(eval); // from black's point of view
+        GoBoard* board = new GoBoard(m_board.Size());
+        factory.AddBoard(board);
+        string suffix = "-" + lexical_cast<string>(GetNumThreads());
+        RlAlphaBeta* helper = dynamic_cast<RlAlphaBeta*>(
+            factory.Clone(id, *board, suffix, shared));
+        SG_ASSERT(helper);
+        helper->m_hashTable = m_hashTable;
+        helper->m_numBuckets = m_numBuckets;
+        helper->m_ownsHash = false;
+        helper->m_numThreads = 1;
+        helper->m_stop = &m_stopHelpers;
+        m_helpers.push_back(helper);
+    }
+    RlDebug(RlSetup::VOCAL) << "Alpha-beta search with " 
+        << GetNumThreads() << " threads\n";
+}
+
+void RlAlphaBeta::StartHelpers(thread_group& threads)
+{
+    m_stopHelpers = false;
+    for (int i = 0; i < ssize(m_helpers); ++i)
+    {
+        RlAlphaBeta* helper = m_helpers[i];
+        CopyBoard(m_board, helper->m_board);
+        helper->m_evaluator->Reset();
+        helper->m_maxDepth = m_maxDepth;
+        helper->m_maxReductions = m_maxReductions;
+        helper->m_maxExtensions = m_maxExtensions;
+        helper->m_generation = m_generation;
+        helper->m_helperError.clear();
+        
+        // Half of the helpers start one iteration deeper than the main
+        // search, so that threads diverge and fill the table with 
+        // different parts of the tree
+        int startdepth = 1 + (i + 1) % 2;
+        threads.create_thread(
+            bind(&RlAlphaBeta::HelperSearch, helper, startdepth));
+    }
+}
+
+void RlAlphaBeta::StopHelpers(thread_group& threads)
+{
+    m_stopHelpers = true;
+    threads.join_all();
+    for (int i = 0; i < ssize(m_helpers); ++i)
+    {
+        RlAlphaBeta* helper = m_helpers[i];
+        if (!helper->m_helperError.empty())
+            throw SgException("Alpha-beta helper failed: " 
+                + helper->m_helperError);
+    }
+}
+
+void RlAlphaBeta::HelperSearch(int startdepth)
+{
+    // Exceptions must not escape the thread; they are rethrown by main search
+    try
+    {
+        ResizeMoveStacks();
+        for (m_iterationDepth = startdepth; 
+            m_iterationDepth <= m_maxDepth && !Stopped(); 
+            ++m_iterationDepth)
+        {
+            ClearStatistics();
+            SortMoves(m_sortedMoves);
+            AlphaBeta(m_iterationDepth, -RL_SEARCH_MAX, +RL_SEARCH_MAX, 
+                0, 0, 0);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        m_helperError = e.what();
     }
 }
 
@@ -97,6 +224,8 @@ int RlAlphaBeta::AlphaBeta(int depth, int alpha, int beta,
     bool lower = false;
     SgMove bestMove = SG_NULLMOVE;
     bool parity = (numExtensions % 2) == 0;
+    if (Stopped())
+        return 0;
     m_stats[depth][STAT_NODES]++;
 
     // Make sure that all lines are evaluated to same parity 
@@ -121,6 +250,8 @@ int RlAlphaBeta::AlphaBeta(int depth, int alpha, int beta,
         m_stats[depth][STAT_REDUCTIONS]++;
         eval = AlphaBeta(depth - 2, beta + m_cutMargin - 1, beta + m_cutMargin, 
             numReductions + 1, numExtensions, child); // reduce recursively
+        if (Stopped())
+            return 0;
         if (eval >= beta + m_cutMargin)
             return BetaCut(depth, beta, ProbeBestMove(), STAT_REDCUTS);
     }
@@ -131,6 +262,8 @@ int RlAlphaBeta::AlphaBeta(int depth, int alpha, int beta,
         m_stats[depth][STAT_PVS]++;
         eval = AlphaBeta(depth, beta - 1, beta, 
             numReductions, numExtensions, child);
+        if (Stopped())
+            return 0;
         if (eval >= beta)
             return BetaCut(depth, beta, ProbeBestMove(), STAT_PVSCUTS);
     }
@@ -138,22 +271,23 @@ int RlAlphaBeta::AlphaBeta(int depth, int alpha, int beta,
     if (bestMove == SG_NULLMOVE)
         bestMove = ProbeBestMove();
         
-    // Move generation
-    vector<SgMove> moves, extensions;
-    GenerateMoves(moves, depth, bestMove);
+    // Move generation, into the preallocated stack for this ply
+    SG_ASSERT(m_variation.size() < m_moveStacks.size());
+    MoveStack& stack = m_moveStacks[m_variation.size()];
+    GenerateMoves(stack, depth, bestMove);
+    stack.m_numExtensions = 0;
     if (numExtensions < m_maxExtensions)
-        GenerateExtensions(extensions);
+        GenerateExtensions(stack);
 
     // Main loop
     m_stats[depth][STAT_FULLWIDTH]++;
     child = 0;
-    for (vector<SgMove>::reverse_iterator i_moves = moves.rbegin(); 
-        i_moves != moves.rend(); ++i_moves)
+    for (SgMove move = PickMove(stack); move != SG_NULLMOVE; 
+        move = PickMove(stack))
     {
-        SgMove move = *i_moves;
         if (ConsiderMove(move))
         {
-            bool isExtension = Contains(extensions, move);
+            bool isExtension = IsExtension(stack, move);
             if (isExtension)
                 m_stats[depth][STAT_EXTENSIONS]++;
 
@@ -162,6 +296,8 @@ int RlAlphaBeta::AlphaBeta(int depth, int alpha, int beta,
                 -beta, -alpha, 
                 0, numExtensions + isExtension, child);
             Undo();
+            if (Stopped())
+                return 0;
             m_stats[depth][STAT_CHILDREN]++;
             
             if (eval >= beta)
@@ -193,48 +329,69 @@ int RlAlphaBeta::BetaCut(int depth, int beta, SgMove bestMove, int stat)
 
 void RlAlphaBeta::SortMoves(vector<SgMove>& moves)
 {
-    RlMoveSorter sorter;
+    // Member sorter and move list keep their capacity between calls
+    m_sorter.ClearMoves();
     for (GoBoard::Iterator i_board(m_board); i_board; ++i_board)
     {
         SgPoint move = *i_board;
         int h = ConsiderMove(move) ? m_history[move] : -1;
-        sorter.AddMove(move, h);
+        m_sorter.AddMove(move, h);
     }
-    sorter.SortMoves(m_board.ToPlay()); // best moves will be last
+    m_sorter.SortMoves(m_board.ToPlay()); // best moves will be last
 
     moves.clear();
     moves.push_back(SG_PASS);
-    for (int i = 0; i < sorter.GetNumMoves(); ++i)
-        moves.push_back(sorter.GetMove(i));
+    for (int i = 0; i < m_sorter.GetNumMoves(); ++i)
+        moves.push_back(m_sorter.GetMove(i));
+}
+
+void RlAlphaBeta::ResizeMoveStacks()
+{
+    // Deepest variation is full depth, extensions, and one parity move.
+    // Resizing only happens between searches, never during search.
+    int numstacks = m_maxDepth + m_maxExtensions + 2;
+    if (ssize(m_moveStacks) < numstacks)
+        m_moveStacks.resize(numstacks);
+    m_variation.reserve(RL_MAX_DEPTH);
+    m_sortedMoves.reserve(RL_MAX_MOVES);
 }
 
-void RlAlphaBeta::GenerateMoves(vector<SgMove>& moves, 
-    int depth, SgMove bestMove)
+void RlAlphaBeta::GenerateMoves(MoveStack& stack, int depth, SgMove bestMove)
 {
+    // Include all points, ordered by root evaluation
+    // Legality will only be evaluated when moves are about to be played.
+    // A re-sort must be copied, as nodes below will sort m_sortedMoves again
     if (depth >= m_sortDepth)
+    {
         SortMoves(m_sortedMoves);
+        copy(m_sortedMoves.begin(), m_sortedMoves.end(), stack.m_sorted);
+        stack.m_order = stack.m_sorted;
+    }
+    else
+        stack.m_order = &m_sortedMoves[0];
+    stack.m_numOrder = ssize(m_sortedMoves);
+    stack.m_nextOrder = stack.m_numOrder;
+    stack.m_numPriority = 0;
+    stack.m_nextPriority = 0;
+    stack.m_picked.reset();
 
-    // Include all points, ordered by root evaluation
-    // Legality will only be evaluated when moves are about to be played
-    moves = m_sortedMoves;
+    // Best move from previous iteration first
+    Promote(stack, bestMove);
 
-    // Promote capturing and capture defending moves
+    // Then killer moves
+    if (m_killerHeuristic)
+        PromoteKillers(stack, depth);
+
+    // Then capturing and capture defending moves
     for (GoBlockIterator i_block(m_board); i_block; ++i_block)
     {
         SgPoint pt = *i_block;
         if (m_board.InAtari(pt))
-            Promote(moves, m_board.TheLiberty(pt));
+            Promote(stack, m_board.TheLiberty(pt));
     }
-
-    // Promote killer moves
-    if (m_killerHeuristic)
-        PromoteKillers(moves, depth);
-
-    // Promote best move from previous iteration
-    Promote(moves, bestMove);
 }
 
-void RlAlphaBeta::GenerateExtensions(vector<SgMove>& extensions)
+void RlAlphaBeta::GenerateExtensions(MoveStack& stack)
 {
     // Extend ladders from last move only
     SgMove lastmove = m_board.GetLastMove();
@@ -245,52 +402,115 @@ void RlAlphaBeta::GenerateExtensions(vector<SgMove>& extensions)
     SgPoint anchor = m_board.Anchor(lastmove);
     if (m_board.NumLiberties(anchor) <= 2)
         for (GoBoard::LibertyIterator i_lib(m_board, anchor); i_lib; ++i_lib)
-            extensions.push_back(*i_lib);
+            stack.m_extensions[stack.m_numExtensions++] = *i_lib;
     
     // Defend (and also capture when opponent plays himself into atari)
     for (SgNb4Iterator i_nb(lastmove); i_nb; ++i_nb)
         if (m_board.Occupied(*i_nb) && m_board.InAtari(*i_nb))
-            extensions.push_back(m_board.TheLiberty(*i_nb));
+            stack.m_extensions[stack.m_numExtensions++] 
+                = m_board.TheLiberty(*i_nb);
 }
 
-void RlAlphaBeta::PromoteKillers(vector<SgMove>& moves, int depth)
+void RlAlphaBeta::PromoteKillers(MoveStack& stack, int depth)
 {
-    for (int n = m_opponentKillers - 1; n >= 0; --n)
-        Promote(moves, m_killer[depth + 1].GetKiller(n));
-    for (int n = m_numKillers - 1; n >= 0; --n)
-        Promote(moves, m_killer[depth].GetKiller(n));
+    for (int n = 0; n < m_numKillers; ++n)
+        Promote(stack, m_killer[depth].GetKiller(n));
+    for (int n = 0; n < m_opponentKillers; ++n)
+        Promote(stack, m_killer[depth + 1].GetKiller(n));
 }
 
-inline void RlAlphaBeta::Promote(vector<SgMove>& moves, SgMove move)
+inline void RlAlphaBeta::Promote(MoveStack& stack, SgMove move)
 {
-    if (move == SG_NULLMOVE)
+    if (move == SG_NULLMOVE || stack.m_picked[move])
         return;
         
-    vector<SgMove>::iterator pos = find(moves.begin(), moves.end(), move);
-    if (pos != moves.end())
-        moves.erase(pos);
-    moves.push_back(move);
+    stack.m_picked.set(move);
+    stack.m_priority[stack.m_numPriority++] = move;
+}
+
+inline SgMove RlAlphaBeta::PickMove(MoveStack& stack)
+{
+    // Promoted moves, in the order they were promoted
+    if (stack.m_nextPriority < stack.m_numPriority)
+        return stack.m_priority[stack.m_nextPriority++];
+
+    // Remaining moves, best history score first
+    while (stack.m_nextOrder > 0)
+    {
+        SgMove move = stack.m_order[--stack.m_nextOrder];
+        if (!stack.m_picked[move])
+            return move;
+    }
+    return SG_NULLMOVE;
+}
+
+inline bool RlAlphaBeta::IsExtension(const MoveStack& stack, 
+    SgMove move) const
+{
+    for (int i = 0; i < stack.m_numExtensions; ++i)
+        if (stack.m_extensions[i] == move)
+            return true;
+    return false;
 }
 
-inline RlAlphaBeta::HashEntry& RlAlphaBeta::LookupHash()
+inline RlAlphaBeta::HashKey RlAlphaBeta::GetHashKey() const
 {
     RlHash hashcode = m_board.GetHashCodeInclToPlay();
-    int index = hashcode.Hash(m_hashSize);
-    return m_hashTable[index];
+    return (HashKey) hashcode.Code2() << 32 | hashcode.Code1();
 }
 
-inline const RlAlphaBeta::HashEntry& RlAlphaBeta::LookupHash() const
+inline RlAlphaBeta::HashBucket& RlAlphaBeta::LookupHash()
 {
     RlHash hashcode = m_board.GetHashCodeInclToPlay();
-    int index = hashcode.Hash(m_hashSize);
+    int index = hashcode.Hash(m_numBuckets);
     return m_hashTable[index];
 }
 
+inline bool RlAlphaBeta::ReadHash(HashData& data, bool& empty)
+{
+    // Read each word once, then validate the pair against the key.
+    // Unused entries are all zero, so their key is zero.
+    HashKey key = GetHashKey();
+    HashBucket& bucket = LookupHash();
+    empty = false;
+    for (int i = 0; i < RL_HASH_BUCKET; ++i)
+    {
+        HashEntry& entry = bucket.m_entries[i];
+        HashKey packed = entry.m_data;
+        HashKey check = entry.m_check;
+        if ((check ^ packed) == key)
+        {
+            UnpackHash(packed, data);
+            return true;
+        }
+        if ((check ^ packed) == 0)
+            empty = true;
+    }
+    return false;
+}
+
+inline void RlAlphaBeta::WriteHash(HashEntry& entry, const HashData& data)
+{
+    HashKey packed = PackHash(data);
+    entry.m_check = GetHashKey() ^ packed;
+    entry.m_data = packed;
+}
+
+inline int RlAlphaBeta::ReplaceScore(const HashData& data) const
+{
+    // Prefer to keep deep entries from recent searches; 
+    // unused entries have generation zero and are always replaced first
+    int age = (m_generation - data.m_generation) & 0xffff;
+    return data.m_depth - 4 * age;
+}
+
 inline SgMove RlAlphaBeta::ProbeBestMove()
 {
-    HashEntry& entry = LookupHash();
-    if (entry.m_hash == m_board.GetHashCodeInclToPlay())
-        return entry.m_bestMove;
+    // Best moves from previous generations are still good for move ordering
+    HashData data;
+    bool empty;
+    if (ReadHash(data, empty))
+        return data.m_bestMove;
     else
         return SG_NULLMOVE;
 }
@@ -298,34 +518,37 @@ inline SgMove RlAlphaBeta::ProbeBestMove()
 inline bool RlAlphaBeta::ProbeHash(int depth, int& alpha, int& beta, 
     int& eval, SgMove& bestMove)
 {
-    HashEntry& entry = LookupHash();
-    if (entry.m_hash == m_board.GetHashCodeInclToPlay())
+    HashData data;
+    bool empty;
+    if (ReadHash(data, empty))
     {
         m_stats[depth][STAT_HASHHITS]++;
-        bestMove = entry.m_bestMove;
-        if (entry.m_depth >= depth)
+        bestMove = data.m_bestMove;
+
+        // Values from previous searches may use a different evaluation 
+        if (data.m_depth >= depth && data.m_generation == m_generation)
         {
-            if (entry.m_upperBound <= alpha)
+            if (data.m_upperBound <= alpha)
             {
                 eval = alpha;
                 m_stats[depth][STAT_HASHCUTS]++;
                 return true;
             }
-            if (entry.m_lowerBound >= beta)
+            if (data.m_lowerBound >= beta)
             {
                 eval = beta;
                 m_stats[depth][STAT_HASHCUTS]++;
                 return true;
             }
-            if (entry.m_lowerBound > alpha)
-                alpha = entry.m_lowerBound;
-            if (entry.m_upperBound < beta)
-                beta = entry.m_upperBound;
+            if (data.m_lowerBound > alpha)
+                alpha = data.m_lowerBound;
+            if (data.m_upperBound < beta)
+                beta = data.m_upperBound;
         }
     }
     else 
     {
-        if (entry.m_hash == RlHash(0))
+        if (empty)
             m_stats[depth][STAT_HASHMISSES]++;
         else
             m_stats[depth][STAT_COLLISIONS]++;
@@ -336,38 +559,158 @@ inline bool RlAlphaBeta::ProbeHash(int depth, int& alpha, int& beta,
 inline void RlAlphaBeta::StoreHash(int depth, SgMove move, int eval,
     bool lower, bool upper)
 {
-    HashEntry& entry = LookupHash();
-
-    // Replace entry
-    if (depth > entry.m_depth)
+    // Entries are written without locking. A concurrent write from another
+    // thread may be lost, or may invalidate the entry, but never corrupts it.
+    HashKey key = GetHashKey();
+    HashBucket& bucket = LookupHash();
+    HashEntry* replace = 0;
+    int worstScore = 0;
+    HashData data;
+    for (int i = 0; i < RL_HASH_BUCKET; ++i)
     {
-        entry.m_hash = m_board.GetHashCodeInclToPlay();
-        entry.m_depth = depth;
-        entry.m_bestMove = move;
-        entry.m_lowerBound = lower ? eval : -RL_SEARCH_MAX;
-        entry.m_upperBound = upper ? eval : +RL_SEARCH_MAX;
-    }
-    
-    // Update bounds
-    else if (depth == entry.m_depth && 
-        entry.m_hash == m_board.GetHashCodeInclToPlay())
-    {    
-        if (lower)
+        HashEntry& entry = bucket.m_entries[i];
+        HashKey packed = entry.m_data;
+        HashKey check = entry.m_check;
+        HashData entryData;
+        UnpackHash(packed, entryData);
+        if ((check ^ packed) == key)
         {
-            SG_ASSERT(eval >= entry.m_lowerBound);
-            entry.m_lowerBound = eval;
-            entry.m_bestMove = move;
+            // Update bounds of current entry at same depth
+            if (entryData.m_generation == m_generation 
+                && depth == entryData.m_depth)
+            {
+                // Another thread may have stored a bound from a different
+                // window that contradicts the new bound: replace the entry
+                if ((lower && eval > entryData.m_upperBound)
+                    || (upper && eval < entryData.m_lowerBound))
+                {
+                    replace = &entry;
+                    break;
+                }
+                if (lower)
+                {
+                    SG_ASSERT(!m_helpers.empty() || m_stop 
+                        || eval >= entryData.m_lowerBound);
+                    entryData.m_lowerBound = 
+                        max(entryData.m_lowerBound, eval);
+                    entryData.m_bestMove = move;
+                }
+                if (upper)
+                {
+                    SG_ASSERT(!m_helpers.empty() || m_stop 
+                        || eval <= entryData.m_upperBound);
+                    entryData.m_upperBound = 
+                        min(entryData.m_upperBound, eval);
+                    entryData.m_bestMove = move;
+                }
+                SG_ASSERT(entryData.m_lowerBound <= entryData.m_upperBound);
+                WriteHash(entry, entryData);
+                return;
+            }
+
+            // Keep deeper result for same position from this search
+            if (entryData.m_generation == m_generation 
+                && depth < entryData.m_depth)
+                return;
+
+            replace = &entry;
+            break;
         }
-        if (upper)
+
+        // Otherwise replace the shallowest, oldest entry in the bucket
+        int score = ReplaceScore(entryData);
+        if (!replace || score < worstScore)
         {
-            SG_ASSERT(eval <= entry.m_upperBound);
-            entry.m_upperBound = eval;
-            entry.m_bestMove = move;
+            replace = &entry;
+            worstScore = score;
         }
     }
+
+    data.m_depth = depth;
+    data.m_bestMove = move;
+    data.m_lowerBound = lower ? eval : -RL_SEARCH_MAX;
+    data.m_upperBound = upper ? eval : +RL_SEARCH_MAX;
+    data.m_generation = m_generation;
+    WriteHash(*replace, data);
 }
 
 void RlAlphaBeta::Clear()
+{
+    ClearHeuristics();
+    for (int i = 0; i < ssize(m_helpers); ++i)
+        m_helpers[i]->ClearHeuristics();
+
+    // Generation zero is reserved for unused entries, so the table is
+    // only wiped when the generation counter wraps around
+    m_generation = (m_generation + 1) & 0xffff;
+    if (m_generation == 0)
+    {
+        m_generation = 1;
+        if (m_hashTable)
+        {
+            RlDebug(RlSetup::VOCAL) << "Clearing hash table...";
+            memset(m_hashTable, 0, m_hashBytes);
+            RlDebug(RlSetup::VOCAL) << " done\n";
+        }
+    }
+};
+
+void RlAlphaBeta::AllocateHash()
+{
+    m_numBuckets = max(m_hashSize / RL_HASH_BUCKET, 1);
+    m_hashBytes = m_numBuckets * sizeof(HashBucket);
+    m_hashMapped = false;
+    void* memory = 0;
+
+#ifdef MAP_HUGETLB
+    // Explicit huge pages must be reserved by the system administrator
+    if (m_largePages)
+    {
+        const size_t hugePage = 2 * 1024 * 1024;
+        m_hashBytes = (m_hashBytes + hugePage - 1) / hugePage * hugePage;
+        memory = mmap(0, m_hashBytes, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory == MAP_FAILED)
+        {
+            RlDebug(RlSetup::VOCAL) << "Large pages not available\n";
+            memory = 0;
+            m_hashBytes = m_numBuckets * sizeof(HashBucket);
+        }
+        else
+            m_hashMapped = true;
+    }
+#endif
+
+    // Otherwise page aligned memory, which is also cache line aligned
+    if (!memory)
+    {
+        if (posix_memalign(&memory, 4096, m_hashBytes) != 0)
+            throw SgException("Failed to allocate hash table");
+        memset(memory, 0, m_hashBytes);
+#ifdef MADV_HUGEPAGE
+        if (m_largePages)
+            madvise(memory, m_hashBytes, MADV_HUGEPAGE);
+#endif
+    }
+
+    m_hashTable = static_cast<HashBucket*>(memory);
+    RlDebug(RlSetup::VOCAL) << "Hash table: " << m_numBuckets 
+        << " buckets, " << m_hashBytes / (1024 * 1024) << "Mb"
+        << (m_hashMapped ? " in large pages\n" : "\n");
+}
+
+void RlAlphaBeta::FreeHash()
+{
+    if (!m_hashTable)
+        return;
+    if (m_hashMapped)
+        munmap(m_hashTable, m_hashBytes);
+    else
+        free(m_hashTable);
+    m_hashTable = 0;
+}
+
+void RlAlphaBeta::ClearHeuristics()
 {
     if (m_killerHeuristic)
         for (int depth = 0; depth < RL_MAX_DEPTH; depth++)
@@ -376,19 +719,7 @@ void RlAlphaBeta::Clear()
     if (m_historyHeuristic)
         for (int i = 0; i < RL_MAX_MOVES; ++i)
             m_history[i] = 0;
-
-    RlDebug(RlSetup::VOCAL) << "Clearing hash table...";
-    for (int i = 0; i < m_hashSize; ++i)
-    {
-        HashEntry& entry = m_hashTable[i];
-        entry.m_hash = RlHash(0);
-        entry.m_depth = -RL_MAX_DEPTH;
-        entry.m_bestMove = SG_NULLMOVE;
-        entry.m_lowerBound = -RL_SEARCH_MAX;
-        entry.m_upperBound = +RL_SEARCH_MAX;
-    }    
-    RlDebug(RlSetup::VOCAL) << " done\n";
-};
+}
 
 inline int RlAlphaBeta::Evaluate(int depth)
 {
@@ -465,14 +796,15 @@ bool RlAlphaBeta::CheckAbort()
 void RlAlphaBeta::PrincipalVariation(vector<SgMove>& pv)
 {
     // Walk the transposition table to retrieve the principal variation
-    HashEntry entry = LookupHash();
-    while (entry.m_hash == m_board.GetHashCodeInclToPlay()
-        && entry.m_bestMove != SG_NULLMOVE
-        && entry.m_lowerBound == entry.m_upperBound
+    HashData data;
+    bool empty;
+    while (ReadHash(data, empty)
+        && data.m_generation == m_generation
+        && data.m_bestMove != SG_NULLMOVE
+        && data.m_lowerBound == data.m_upperBound
         && !TwoPasses(m_board))
     {
-        Play(entry.m_bestMove);
-        entry = LookupHash();
+        Play(data.m_bestMove);
     }
 
     pv = m_variation;
@@ -6,12 +6,17 @@
 #ifndef RL_ALPHABETA_H
 #define RL_ALPHABETA_H
 
+#include "RlEvaluator.h"
 #include "RlUtils.h"
 #include "SgTimer.h"
+#include <bitset>
+#include <string>
+#include <boost/thread/thread.hpp>
 
 const int RL_SEARCH_MAX = 1600;
 const int RL_MAX_KILLERS = 16;
 const int RL_MAX_DEPTH = SG_MAX_MOVES * 2;
+const int RL_HASH_BUCKET = 4; // entries per 64 byte cache line
 
 using namespace RlMathUtil;
 
@@ -35,8 +40,12 @@ public:
         Returns root value and principal variation. */
     RlFloat Search(std::vector<SgMove>& pv);
 
-    /** Clear hash table and other search data */
+    /** Clear search data. Hash table entries from previous searches are
+        only retained for move ordering, by advancing the table generation */
     void Clear();
+
+    /** Number of threads used by parallel search, including this one */
+    int GetNumThreads() const { return ssize(m_helpers) + 1; }
     
     void SetMaxDepth(int value) { m_maxDepth = value; }
     void SetMaxTime(double value) { m_maxTime = value; }
@@ -61,15 +70,62 @@ public:
         SgMove m_killerMoves[RL_MAX_KILLERS];
     };
 
-private:
+    typedef unsigned long long HashKey;
 
-    struct HashEntry
+    /** Unpacked contents of a hash table entry */
+    struct HashData
     {
-        RlHash m_hash;
         int m_depth;
         int m_lowerBound;
         int m_upperBound;
         SgMove m_bestMove;
+        int m_generation;
+    };
+
+    static HashKey PackHash(const HashData& data);
+    static void UnpackHash(HashKey packed, HashData& data);
+
+private:
+
+    /** Hash table entry, shared between all threads of a parallel search.
+        The data is packed into a single word and the key is stored XORed 
+        with the data, so that an entry torn by concurrent writes fails 
+        validation instead of returning another position's data. */
+    struct HashEntry
+    {
+        volatile HashKey m_check;
+        volatile HashKey m_data;
+    };
+
+    /** Preallocated moves for one ply of the search. Moves are picked in
+        stages: hash move, killers and atari moves first, in the order they 
+        were added, then all other moves in history order. */
+    struct MoveStack
+    {
+        /** Moves to try first, and the set of moves already in this list */
+        SgMove m_priority[RL_MAX_MOVES];
+        int m_numPriority;
+        std::bitset<RL_MAX_MOVES> m_picked;
+        
+        /** All moves ordered by history, best moves last. Points either
+            to m_sorted, or to m_sortedMoves when not sorted at this ply */
+        SgMove m_sorted[RL_MAX_MOVES];
+        const SgMove* m_order;
+        int m_numOrder;
+
+        /** Moves that extend the search depth (ladder moves) */
+        SgMove m_extensions[8];
+        int m_numExtensions;
+
+        /** Position of the next move to pick, in each stage */
+        int m_nextPriority;
+        int m_nextOrder;
+    };
+
+    /** Set of entries sharing one cache line */
+    struct HashBucket
+    {
+        HashEntry m_entries[RL_HASH_BUCKET];
     };
 
     enum
@@ -98,12 +154,20 @@ private:
     int BetaCut(int depth, int beta, SgMove bestMove, int stat);
     void PrincipalVariation(std::vector<SgMove>& pv);
     void SortMoves(std::vector<SgMove>& moves);
-    void GenerateMoves(std::vector<SgMove>& moves, int depth, SgMove bestMove);
-    void GenerateExtensions(std::vector<SgMove>& extensions);
-    void PromoteKillers(std::vector<SgMove>& moves, int depth);
-    void Promote(std::vector<SgMove>& moves, SgMove move);
-    HashEntry& LookupHash();
-    const HashEntry& LookupHash() const;
+    void GenerateMoves(MoveStack& stack, int depth, SgMove bestMove);
+    void GenerateExtensions(MoveStack& stack);
+    void PromoteKillers(MoveStack& stack, int depth);
+    void Promote(MoveStack& stack, SgMove move);
+    SgMove PickMove(MoveStack& stack);
+    bool IsExtension(const MoveStack& stack, SgMove move) const;
+    void ResizeMoveStacks();
+    HashBucket& LookupHash();
+    HashKey GetHashKey() const;
+    bool ReadHash(HashData& data, bool& empty);
+    void WriteHash(HashEntry& entry, const HashData& data);
+    int ReplaceScore(const HashData& data) const;
+    void AllocateHash();
+    void FreeHash();
     SgMove ProbeBestMove();
     bool ProbeHash(int depth, int& alpha, int& beta, 
         int& eval, SgMove& bestMove);
@@ -121,6 +185,12 @@ private:
     void OutputStatistic(const std::string& name, 
         int stat, std::ostream& ostr);
     void ClearStatistics();
+    void ClearHeuristics();
+    void CreateHelpers();
+    void StartHelpers(boost::thread_group& threads);
+    void StopHelpers(boost::thread_group& threads);
+    void HelperSearch(int startdepth);
+    bool Stopped() const { return m_stop && *m_stop; }
 
     RlEvaluator* m_evaluator;
 
@@ -136,6 +206,9 @@ private:
     /** Number of entries in the hash table */
     int m_hashSize;
 
+    /** Try to allocate hash table in large (huge) pages */
+    bool m_largePages;
+
     /** Perform a full move sort at this depth or more */
     int m_sortDepth;
     
@@ -168,9 +241,39 @@ private:
 
     /** Power to use when estimating time for next iteration */
     RlFloat m_branchPower;
+
+    /** Number of threads to search with (Lazy SMP), including this one */
+    int m_numThreads;
     
-    /** The hash table */
-    HashEntry* m_hashTable;
+    /** The hash table (shared with helper searches) */
+    HashBucket* m_hashTable;
+
+    /** Number of buckets in the hash table */
+    int m_numBuckets;
+
+    /** Size of the hash table allocation */
+    size_t m_hashBytes;
+
+    /** Whether hash table was mapped in large pages */
+    bool m_hashMapped;
+
+    /** Whether this search allocated the hash table */
+    bool m_ownsHash;
+
+    /** Current hash table generation, advanced by each Clear */
+    int m_generation;
+
+    /** Helper searches, each on its own board */
+    std::vector<RlAlphaBeta*> m_helpers;
+
+    /** Set by the main search when helper searches should return */
+    volatile bool m_stopHelpers;
+
+    /** Stop flag of the main search, for helper searches only */
+    volatile bool* m_stop;
+
+    /** Exception message from a helper search, rethrown by main search */
+    std::string m_helperError;
     
     /** Current maximum depth during iterative deepening */
     int m_iterationDepth;
@@ -183,6 +286,12 @@ private:
 
     /** All moves sorted by history score */
     std::vector<SgMove> m_sortedMoves;
+
+    /** Sorter used to order moves by history score */
+    RlMoveSorter m_sorter;
+
+    /** Move generation for each ply of the current variation */
+    std::vector<MoveStack> m_moveStacks;
     
     /** Current variation */
     std::vector<SgMove> m_variation;
@@ -243,6 +352,27 @@ inline void RlAlphaBeta::Killer::MarkKiller(SgMove move)
     m_killerMoves[0] = move;
 }
 
+inline RlAlphaBeta::HashKey RlAlphaBeta::PackHash(const HashData& data)
+{
+    // Depth, bounds and move use 12 bits each (signed), generation 16 bits:
+    // |bounds| <= RL_SEARCH_MAX, moves are points, pass or null move
+    return ((HashKey) data.m_depth & 0xfff)
+        | ((HashKey) data.m_lowerBound & 0xfff) << 12
+        | ((HashKey) data.m_upperBound & 0xfff) << 24
+        | ((HashKey) data.m_bestMove & 0xfff) << 36
+        | ((HashKey) data.m_generation & 0xffff) << 48;
+}
+
+inline void RlAlphaBeta::UnpackHash(HashKey packed, HashData& data)
+{
+    // Sign extend 12 bit fields
+    data.m_depth = (int) ((packed & 0xfff) ^ 0x800) - 0x800;
+    data.m_lowerBound = (int) ((packed >> 12 & 0xfff) ^ 0x800) - 0x800;
+    data.m_upperBound = (int) ((packed >> 24 & 0xfff) ^ 0x800) - 0x800;
+    data.m_bestMove = (int) ((packed >> 36 & 0xfff) ^ 0x800) - 0x800;
+    data.m_generation = (int) (packed >> 48 & 0xffff);
+}
+
 #endif // RL_ALPHABETA_H
 
 //-----------------------------------------------------------------------------
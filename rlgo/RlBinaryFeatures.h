@@ -27,10 +27,16 @@ public:
 
     /** Each binary feature set creates a corresponding tracker object.
         The trackermap ensures that this is only created once for each set.
-        This is used to incrementally track the currently active features */
-    virtual RlTracker* CreateTracker(
+        This is used to incrementally track the currently active features.
+        The tracker follows the specified board, which need not be the board
+        of the feature set, so that one feature set can serve many boards
+        of the same size. */
+    virtual RlTracker* CreateTracker(GoBoard& board,
         std::map<RlBinaryFeatures*, RlTracker*>& trackermap) = 0;
 
+    /** Feature sets are read-only after initialisation */
+    virtual bool IsReadOnly() const { return true; }
+
     /** Get the total number of features in this set.
         If feature discovery is used, this is the total capacity of the set. */
     virtual int GetNumFeatures() const = 0;
@@ -15,6 +15,22 @@ using namespace SgPointUtil;
 
 //----------------------------------------------------------------------------
 
+RlDirtySet::RlDirtySet()
+:   m_undo(false),
+    m_epoch(0)
+{
+    for (int c = 0; c < 2; ++c)
+    {
+        for (int i = 0; i <= SG_PASS; ++i)
+        {
+            m_dirty[c][i] = true;
+            m_diffs[c][i] = 0;
+        }
+        m_pruned[c] = 0;
+        m_journal[c].reserve(16 * (SG_PASS + 1) + 1);
+    }
+}
+
 void RlDirtySet::MarkAtaris(GoBoard& bd, SgMove move, SgBlackWhite colour)
 {
     // Mark ataris as dirty when specified move is executed.
@@ -36,6 +52,7 @@ void RlDirtySet::MarkAtaris(GoBoard& bd, SgMove move, SgBlackWhite colour)
 
 void RlDirtySet::MarkAll(GoBoard& bd)
 {
+    ClearHistory();
     for (GoBoard::Iterator i_board(bd); i_board; ++i_board)
     {
         Mark(*i_board, SG_BLACK);
@@ -43,15 +60,58 @@ void RlDirtySet::MarkAll(GoBoard& bd)
     }
     Mark(SG_PASS, SG_BLACK);
     Mark(SG_PASS, SG_WHITE);
+    Invalidate();
 }
 
 void RlDirtySet::ClearAll(GoBoard& bd)
 {
+    ClearHistory();
     for (GoBoard::Iterator i_board(bd); i_board; ++i_board)
     {
         Clear(*i_board, SG_BLACK);
         Clear(*i_board, SG_WHITE);
     }
+    Invalidate();
+}
+
+void RlDirtySet::EnableUndo(bool enable)
+{
+    m_undo = enable;
+    ClearHistory();
+}
+
+void RlDirtySet::Execute()
+{
+    if (m_undo)
+        m_plies.push_back(m_history.size());
+}
+
+void RlDirtySet::Undo()
+{
+    SG_ASSERT(CanUndo());
+    int start = m_plies.back();
+    m_plies.pop_back();
+    while (ssize(m_history) > start)
+    {
+        const Entry& entry = m_history.back();
+        m_dirty[entry.m_colour][entry.m_move] = entry.m_dirty;
+        m_diffs[entry.m_colour][entry.m_move] = entry.m_diff;
+        m_history.pop_back();
+    }
+    Invalidate();
+}
+
+void RlDirtySet::Invalidate()
+{
+    m_journal[0].clear();
+    m_journal[1].clear();
+    m_epoch++;
+}
+
+void RlDirtySet::ClearHistory()
+{
+    m_history.clear();
+    m_plies.clear();
 }
 
 void RlDirtySet::Print(GoBoard& bd, ostream& str) const
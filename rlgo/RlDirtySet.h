@@ -7,42 +7,153 @@
 #ifndef RLDIRTYSET_H
 #define RLDIRTYSET_H
 
+#include "RlMiscUtil.h"
 #include "RlShapeUtil.h"
 #include "SgBWSet.h"
+#include <vector>
 
 class GoBoard;
 
 //----------------------------------------------------------------------------
-
+/** Set of moves whose cached evaluation differences are dirty, together
+    with the cached differences themselves.
+    If undo is enabled, every change made after Execute is recorded on a 
+    per-ply stack, so that Undo restores exactly the previous dirty flags
+    and differences, rather than marking all moves dirty. */
 class RlDirtySet
 {
 public:
 
+    RlDirtySet();
+
+    /** Clear or mark all moves. Discards the undo history. */
     void ClearAll(GoBoard& bd);
     void MarkAll(GoBoard& bd);
+
     void Clear(SgMove move, SgBlackWhite colour);
     void Mark(SgMove move, SgBlackWhite colour);
     bool IsDirty(SgMove move, SgBlackWhite colour) const;
     void MarkAtaris(GoBoard& bd, SgMove move, SgBlackWhite colour);
     void Print(GoBoard& bd, std::ostream& str) const;
 
+    /** Cached difference to evaluation for move */
+    RlFloat GetDiff(SgMove move, SgBlackWhite colour) const;
+
+    /** Store difference to evaluation for move, and clear its dirty flag */
+    void SetDiff(SgMove move, SgBlackWhite colour, RlFloat diff);
+
+    /** Whether to record changes so that they can be undone */
+    void EnableUndo(bool enable);
+    bool CanUndo() const { return !m_plies.empty(); }
+
+    /** Start a new ply: subsequent changes are undone by Undo */
+    void Execute();
+
+    /** Restore dirty flags and differences to the start of the last ply */
+    void Undo();
+
     /** Count how frequently moves are pruned by difference evaluation */
     void IncPruned(bool pruned) { m_pruned[pruned]++; }
 
+    /** Journal of moves marked dirty, for each colour, for consumers that 
+        cache values derived from the differences. A consumer remembers the
+        epoch and its position in the journal. The epoch changes whenever
+        the journal can't describe the changes (e.g. after MarkAll or Undo),
+        and consumers must then recompute all moves. */
+    int GetEpoch() const { return m_epoch; }
+    int GetJournalSize(SgBlackWhite colour) const;
+    SgMove GetJournalMove(SgBlackWhite colour, int i) const;
+
+    /** Add move to the journal of both colours, without marking it dirty.
+        Used when a point becomes occupied or is captured. */
+    void Touch(SgMove move);
+
 private:
 
+    /** Previous state of one move, before it was changed */
+    struct Entry
+    {
+        short m_colour;
+        short m_move;
+        bool m_dirty;
+        RlFloat m_diff;
+    };
+
+    void Record(int c, SgMove move);
+    void ClearHistory();
+    void Journal(int c, SgMove move);
+    void Invalidate();
+
     bool m_dirty[2][SG_PASS + 1];
+    RlFloat m_diffs[2][SG_PASS + 1];
     int m_pruned[2];
+
+    /** Whether undo history is recorded */
+    bool m_undo;
+
+    /** Previous states of changed moves, for all plies */
+    std::vector<Entry> m_history;
+
+    /** Start of each ply in the history */
+    std::vector<int> m_plies;
+
+    /** Incremented whenever the journals are discarded */
+    int m_epoch;
+
+    /** Moves marked dirty or touched since the journals were discarded */
+    std::vector<SgMove> m_journal[2];
 };
 
+inline void RlDirtySet::Journal(int c, SgMove move)
+{
+    m_journal[c].push_back(move);
+    if (ssize(m_journal[c]) > 16 * (SG_PASS + 1))
+        Invalidate();
+}
+
+inline void RlDirtySet::Record(int c, SgMove move)
+{
+    if (m_plies.empty())
+        return;
+    Entry entry;
+    entry.m_colour = static_cast<short>(c);
+    entry.m_move = static_cast<short>(move);
+    entry.m_dirty = m_dirty[c][move];
+    entry.m_diff = m_diffs[c][move];
+    m_history.push_back(entry);
+}
+
 inline void RlDirtySet::Mark(SgMove move, SgBlackWhite colour)
 {
-    m_dirty[RlShapeUtil::BWIndex(colour)][move] = true;
+    int c = RlShapeUtil::BWIndex(colour);
+    if (m_dirty[c][move])
+        return;
+    Record(c, move);
+    m_dirty[c][move] = true;
+    Journal(c, move);
 }
 
 inline void RlDirtySet::Clear(SgMove move, SgBlackWhite colour)
 {
-    m_dirty[RlShapeUtil::BWIndex(colour)][move] = false;
+    int c = RlShapeUtil::BWIndex(colour);
+    if (!m_dirty[c][move])
+        return;
+    Record(c, move);
+    m_dirty[c][move] = false;
+}
+
+inline RlFloat RlDirtySet::GetDiff(SgMove move, SgBlackWhite colour) const
+{
+    return m_diffs[RlShapeUtil::BWIndex(colour)][move];
+}
+
+inline void RlDirtySet::SetDiff(SgMove move, SgBlackWhite colour, 
+    RlFloat diff)
+{
+    int c = RlShapeUtil::BWIndex(colour);
+    Record(c, move);
+    m_diffs[c][move] = diff;
+    m_dirty[c][move] = false;
 }
 
 inline bool RlDirtySet::IsDirty(SgMove move, SgBlackWhite colour) const
@@ -50,6 +161,22 @@ inline bool RlDirtySet::IsDirty(SgMove move, SgBlackWhite colour) const
     return m_dirty[RlShapeUtil::BWIndex(colour)][move];
 }
 
+inline int RlDirtySet::GetJournalSize(SgBlackWhite colour) const
+{
+    return m_journal[RlShapeUtil::BWIndex(colour)].size();
+}
+
+inline SgMove RlDirtySet::GetJournalMove(SgBlackWhite colour, int i) const
+{
+    return m_journal[RlShapeUtil::BWIndex(colour)][i];
+}
+
+inline void RlDirtySet::Touch(SgMove move)
+{
+    Journal(0, move);
+    Journal(1, move);
+}
+
 //----------------------------------------------------------------------------
 
 #endif // RLDIRTYSET_H
@@ -9,10 +9,15 @@
 #include "GoBoard.h"
 #include "RlBinaryFeatures.h"
 #include "RlMoveFilter.h"
+#include "RlRandomUtil.h"
+#include "RlSetup.h"
 #include "RlUtils.h"
+#include "RlSimdUtil.h"
 #include "RlState.h"
 #include "RlWeightSet.h"
 
+#include <math.h>
+
 using namespace boost;
 using namespace std;
 using namespace RlShapeUtil;
@@ -28,20 +33,28 @@ RlEvaluator::RlEvaluator(GoBoard& board,
     m_weightSet(weightset),
     m_moveFilter(filter),
     m_differences(false),
-    m_supportUndo(true)
+    m_supportUndo(true),
+    m_deltaCacheBits(0),
+    m_rebuildInterval(0),
+    m_numReal(0),
+    m_realDepth(0)
 {
 }
 
 void RlEvaluator::LoadSettings(istream& settings)
 {
     int version;
-    settings >> RlVersion(version, 6, 6);
+    settings >> RlVersion(version, 8, 6);
 
     settings >> RlSetting<RlBinaryFeatures*>("FeatureSet", m_featureSet);
     settings >> RlSetting<RlWeightSet*>("WeightSet", m_weightSet);
     settings >> RlSetting<RlMoveFilter*>("MoveFilter", m_moveFilter);
     settings >> RlSetting<bool>("Differences", m_differences);
     settings >> RlSetting<bool>("SupportUndo", m_supportUndo);
+    if (version >= 7)
+        settings >> RlSetting<int>("DeltaCache", m_deltaCacheBits);
+    if (version >= 8)
+        settings >> RlSetting<int>("RebuildInterval", m_rebuildInterval);
 }
 
 void RlEvaluator::Initialise()
@@ -52,9 +65,22 @@ void RlEvaluator::Initialise()
     
     // Tracker map ensures that each feature creates just one tracker
     map<RlBinaryFeatures*, RlTracker*> trackermap;
-    m_tracker = m_featureSet->CreateTracker(trackermap);
+    m_tracker = m_featureSet->CreateTracker(m_board, trackermap);
     m_tracker->Initialise();    
     m_active.Resize(m_tracker->GetActiveSize());
+    m_dirty.EnableUndo(m_differences && m_supportUndo);
+
+    if (m_deltaCacheBits > 0)
+    {
+        m_weightSet->EnableStamps();
+        DeltaEntry empty;
+        empty.m_from = -1;
+        empty.m_to = -1;
+        empty.m_stamp = 0;
+        empty.m_epoch = 0;
+        empty.m_delta = 0;
+        m_deltaCache.assign(1 << m_deltaCacheBits, empty);
+    }
 }
 
 void RlEvaluator::Reset()
@@ -73,16 +99,19 @@ void RlEvaluator::Reset()
     m_tracker->Reset();
     m_active.Clear();
     AddWeightsUpdateActive(m_tracker->ChangeList(), m_eval);
+    m_numReal = 0;
+    m_realDepth = 0;
 }
 
 void RlEvaluator::Execute(SgMove move, SgBlackWhite colour, bool real)
 {
-    // When a real move is executed, fully update internal representation
+    // When a real move is executed, update incrementally,
+    // and refresh the evaluation to take account of weight changes
     if (real)
     {
         if (m_tracker->MarkSet())
             throw SgException("Can't set mark for real execution");
-        Reset();
+        ExecuteReal(move, colour);
     }
 
     // When a simulated move is executed, update incrementally
@@ -91,7 +120,16 @@ void RlEvaluator::Execute(SgMove move, SgBlackWhite colour, bool real)
         m_tracker->Execute(move, colour, true, m_supportUndo);
         AddWeightsUpdateActive(m_tracker->ChangeList(), m_eval);
         if (m_differences)
+        {
+            m_dirty.Execute();
             m_tracker->UpdateDirty(move, colour, m_dirty);
+
+            // Journal occupancy changes for incremental move selection
+            m_dirty.Touch(move);
+            for (GoPointList::Iterator i_captures(m_board.CapturedStones()); 
+                i_captures; ++i_captures)
+                m_dirty.Touch(*i_captures);
+        }
         if (m_moveFilter)
             m_moveFilter->Execute(move, colour);        
     }
@@ -105,9 +143,9 @@ void RlEvaluator::PlayExecute(SgMove move, SgBlackWhite colour, bool real)
 
 void RlEvaluator::Undo(bool real)
 {
-    // When a real move is undone, fully update internal representation
+    // When a real move is undone, update incrementally if possible
     if (real)
-        Reset();
+        UndoReal();
 
     // When a simulated move is undone, update incrementally
     else
@@ -118,7 +156,13 @@ void RlEvaluator::Undo(bool real)
         AddWeightsUpdateActive(m_tracker->ChangeList(), m_eval);
         
         if (m_differences)
-            m_dirty.MarkAll(m_board); // @todo: could do something smarter here
+        {
+            // Restore the dirty set from before the move, if possible
+            if (m_dirty.CanUndo())
+                m_dirty.Undo();
+            else
+                m_dirty.MarkAll(m_board);
+        }
         if (m_moveFilter)
             m_moveFilter->Undo();
     }
@@ -130,24 +174,112 @@ void RlEvaluator::TakeBackUndo(bool real)
     Undo(real);
 }
 
-inline void RlEvaluator::AddWeights(const RlChangeList& changes, RlFloat& eval)
+void RlEvaluator::ExecuteReal(SgMove move, SgBlackWhite colour)
+{
+    m_tracker->Execute(move, colour, true, m_supportUndo);
+    UpdateActiveReal(m_tracker->ChangeList());
+    if (m_moveFilter)
+        m_moveFilter->Execute(move, colour);
+
+    // Weights may have changed, so all differences are invalid
+    if (m_differences)
+        m_dirty.MarkAll(m_board);
+
+    m_numReal++;
+    if (m_supportUndo)
+        m_realDepth++;
+    RebuildReal();
+}
+
+void RlEvaluator::UndoReal()
+{
+    // Positions before the last full rebuild can't be restored
+    if (m_realDepth == 0)
+    {
+        Reset();
+        return;
+    }
+
+    m_tracker->Undo();
+    UpdateActiveReal(m_tracker->ChangeList());
+    if (m_moveFilter)
+        m_moveFilter->Undo();
+    if (m_differences)
+        m_dirty.MarkAll(m_board);
+
+    m_numReal++;
+    m_realDepth--;
+    RebuildReal();
+}
+
+void RlEvaluator::UpdateActiveReal(const RlChangeList& changes)
 {
     for (RlChangeList::Iterator i_changes(changes); i_changes; ++i_changes)
+        m_active.Change(*i_changes);
+
+    // Use the same precision as AddWeights
+    if (m_weightSet->SinglePrecision())
+        m_eval = RlSimdUtil::GatherDot(m_weightSet->GetSingleWeights(), 
+            m_active.GetIndices(), m_active.GetOccurrences(), 
+            m_active.NumOccupied());
+    else
+        m_eval = RlSimdUtil::GatherDot(m_weightSet->GetWeights(), 
+            m_active.GetIndices(), m_active.GetOccurrences(), 
+            m_active.NumOccupied());
+}
+
+void RlEvaluator::RebuildReal()
+{
+    bool verify = RlSetup::Get()->GetVerification();
+    if (!verify 
+        && (m_rebuildInterval == 0 || m_numReal < m_rebuildInterval))
+        return;
+
+    RlFloat eval = m_eval;
+    Reset();
+    if (verify && fabs(eval - m_eval) > 1e-6)
+        throw SgException("Incremental real move evaluation mismatch");
+}
+
+inline void RlEvaluator::PrefetchWeights(const int* indices, int n) const
+{
+    if (m_weightSet->SinglePrecision())
+        RlSimdUtil::GatherPrefetch(m_weightSet->GetSingleWeights(), 
+            indices, n);
+    else
+        RlSimdUtil::GatherPrefetch(m_weightSet->GetWeights(), indices, n);
+}
+
+void RlEvaluator::Prefetch() const
+{
+    PrefetchWeights(m_active.GetIndices(), m_active.NumOccupied());
+}
+
+inline void RlEvaluator::AddWeights(const RlChangeList& changes, RlFloat& eval)
+{
+    // Gather kernels accumulate at the precision of the weights
+    if (m_weightSet->SinglePrecision())
+    {
+        const float* weights = m_weightSet->GetSingleWeights();
+        eval += RlSimdUtil::GatherDot(weights, 
+            changes.GetIndices(), changes.GetOccurrences(), changes.Size());
+    }
+    else
     {
-        RlWeight& weight = m_weightSet->Get(i_changes->m_featureIndex);
-        eval += weight.Weight() * i_changes->m_occurrences;
+        const RlFloat* weights = m_weightSet->GetWeights();
+        eval += RlSimdUtil::GatherDot(weights, 
+            changes.GetIndices(), changes.GetOccurrences(), changes.Size());
     }
 }
 
 inline void RlEvaluator::AddWeightsUpdateActive(
     const RlChangeList& changes, RlFloat& eval)
 {
+    // Update the active set while the weight cache misses are in flight
+    PrefetchWeights(changes.GetIndices(), changes.Size());
     for (RlChangeList::Iterator i_changes(changes); i_changes; ++i_changes)
-    {
-        RlWeight& weight = m_weightSet->Get(i_changes->m_featureIndex);
-        eval += weight.Weight() * i_changes->m_occurrences;
         m_active.Change(*i_changes);
-    }
+    AddWeights(changes, eval);
 }
 
 RlFloat RlEvaluator::EvaluateMove(SgMove move, SgBlackWhite colour)
@@ -160,14 +292,7 @@ RlFloat RlEvaluator::EvaluateMove(SgMove move, SgBlackWhite colour)
 
 RlFloat RlEvaluator::EvalMoveSimple(SgMove move, SgBlackWhite colour)
 {
-    RlFloat weightchange = 0;
-
-    m_board.Play(move, colour);
-
-    m_tracker->Execute(move, colour, false, false);
-    AddWeights(m_tracker->ChangeList(), weightchange);
-    m_board.Undo();
-    return m_eval + weightchange;
+    return m_eval + EvalMoveChange(move, colour);
 }
 
 RlFloat RlEvaluator::EvalMoveDiffs(SgMove move, SgBlackWhite colour)
@@ -176,26 +301,139 @@ RlFloat RlEvaluator::EvalMoveDiffs(SgMove move, SgBlackWhite colour)
     RlFloat weightchange = 0;
     if (m_dirty.IsDirty(move, colour))
     {
-        m_board.Play(move, colour);
-        m_tracker->Execute(move, colour, false, false);
-        AddWeights(m_tracker->ChangeList(), weightchange);
-        m_diffs[BWIndex(colour)][move] = weightchange;
-        m_dirty.Clear(move, colour);
+        weightchange = EvalMoveChange(move, colour);
+        m_dirty.SetDiff(move, colour, weightchange);
         m_dirty.IncPruned(false);
-        m_board.Undo();
     }
     else
     {
-        weightchange = m_diffs[BWIndex(colour)][move];
+        weightchange = m_dirty.GetDiff(move, colour);
         m_dirty.IncPruned(true);
     }
     
     return m_eval + weightchange;
 }
 
+RlFloat RlEvaluator::EvalMoveChange(SgMove move, SgBlackWhite colour)
+{
+    if (!IsSimpleMove(move, colour)
+        || !m_tracker->ExecuteHypothetical(move, colour))
+        return EvalMovePlay(move, colour);
+
+    RlFloat weightchange = 0;
+    AddMoveWeights(m_tracker->ChangeList(), weightchange);
+
+    if (RlSetup::Get()->GetVerification())
+    {
+        RlFloat playchange = EvalMovePlay(move, colour);
+        if (fabs(playchange - weightchange) > 1e-6)
+            throw SgException("Hypothetical move evaluation mismatch");
+    }
+    return weightchange;
+}
+
+RlFloat RlEvaluator::EvalMovePlay(SgMove move, SgBlackWhite colour)
+{
+    RlFloat weightchange = 0;
+    m_board.Play(move, colour);
+    m_tracker->Execute(move, colour, false, false);
+    const RlChangeList& changes = m_tracker->ChangeList();
+
+    // Undo the board while the weight cache misses are in flight
+    PrefetchWeights(changes.GetIndices(), changes.Size());
+    m_board.Undo();
+    AddMoveWeights(changes, weightchange);
+    return weightchange;
+}
+
+void RlEvaluator::AddMoveWeights(const RlChangeList& changes, RlFloat& eval)
+{
+    if (m_deltaCache.empty())
+    {
+        AddWeights(changes, eval);
+        return;
+    }
+
+    // Features replaced by a successor appear as a (-1, +1) pair of changes
+    const int* indices = changes.GetIndices();
+    const RlOccur* occurrences = changes.GetOccurrences();
+    int numchanges = changes.Size();
+    for (int i = 0; i < numchanges; ++i)
+    {
+        if (occurrences[i] == -1 && i + 1 < numchanges 
+            && occurrences[i + 1] == +1)
+        {
+            eval += CachedDelta(indices[i], indices[i + 1]);
+            ++i;
+        }
+        else if (m_weightSet->SinglePrecision())
+            eval += m_weightSet->GetSingleWeights()[indices[i]] 
+                * occurrences[i];
+        else
+            eval += m_weightSet->GetWeight(indices[i]) * occurrences[i];
+    }
+}
+
+RlFloat RlEvaluator::CachedDelta(int from, int to)
+{
+    unsigned hash = (static_cast<unsigned>(from) * 2654435761u)
+        ^ (static_cast<unsigned>(to) * 40503u);
+    DeltaEntry& entry = m_deltaCache[hash & (m_deltaCache.size() - 1)];
+
+    // Stamps only increase, so their sum identifies both versions
+    const unsigned* stamps = m_weightSet->GetStamps();
+    unsigned stamp = stamps[from] + stamps[to];
+    unsigned epoch = m_weightSet->GetEpoch();
+    if (entry.m_from == from && entry.m_to == to 
+        && entry.m_stamp == stamp && entry.m_epoch == epoch)
+        return entry.m_delta;
+
+    entry.m_from = from;
+    entry.m_to = to;
+    entry.m_stamp = stamp;
+    entry.m_epoch = epoch;
+    if (m_weightSet->SinglePrecision())
+    {
+        const float* weights = m_weightSet->GetSingleWeights();
+        entry.m_delta = weights[to] - weights[from];
+    }
+    else
+        entry.m_delta = m_weightSet->GetWeight(to) 
+            - m_weightSet->GetWeight(from);
+    return entry.m_delta;
+}
+
+bool RlEvaluator::IsSimpleMove(SgMove move, SgBlackWhite colour) const
+{
+    if (move == SG_PASS)
+        return true;
+
+    // Capturing moves must remove stones, so fall back to the board.
+    // A move with no liberty left after playing would be suicide.
+    bool haslib = false;
+    SgBlackWhite opp = SgOppBW(colour);
+    for (SgNb4Iterator i_nb(move); i_nb; ++i_nb)
+    {
+        SgPoint nb = *i_nb;
+        if (m_board.IsEmpty(nb))
+            haslib = true;
+        else if (m_board.IsColor(nb, opp))
+        {
+            if (m_board.InAtari(nb))
+                return false;
+        }
+        else if (m_board.IsColor(nb, colour))
+        {
+            if (m_board.NumLiberties(nb) > 1)
+                haslib = true;
+        }
+    }
+    return haslib;
+}
+
 void RlEvaluator::FindBest(RlState& state)
 {
-    static SgMove ties[SG_MAX_MOVES];
+    SgMove ties[SG_MAX_MOVES];
     int numties = 0;
     SgBlackWhite colour = state.m_colour;
     state.m_bestMove = SG_PASS;
@@ -220,7 +458,7 @@ void RlEvaluator::FindBest(RlState& state)
     // Random tie-breaking
     if (numties > 1)
     {
-        int index = SgRandom::Global().Int(numties);
+        int index = RlRandomUtil::Int(numties);
         state.m_bestMove = ties[index];
     }
 }
@@ -237,14 +475,10 @@ void RlEvaluator::ClearMark()
 
 void RlEvaluator::RefreshValue(RlState& state)
 {
-    RlFloat eval = 0;
-    for (RlActiveSet::Iterator i_active(state.Active()); 
-        i_active; ++i_active)
-    {
-        RlWeight& weight = m_weightSet->Get(i_active->m_featureIndex);
-        eval += weight.Weight() * i_active->m_occurrences;
-    }
-
+    // Always use master weights for a full refresh
+    const RlActiveSnapshot& active = state.Active();
+    RlFloat eval = RlSimdUtil::GatherDot(m_weightSet->GetWeights(), 
+        active.GetIndices(), active.GetOccurrences(), active.NumOccupied());
     state.SetEval(eval);
 }
 
@@ -70,6 +70,10 @@ public:
     void SetMark();
     void ClearMark();
 
+    /** Prefetch weights of the currently active features, which are 
+        gathered again after the next real move */
+    void Prefetch() const;
+
     /** Get move filter */
     const RlMoveFilter* GetMoveFilter() const { return m_moveFilter; }
     
@@ -79,6 +83,12 @@ public:
     /** Get currently tracked change list */
     const RlChangeList& ChangeList() const { return m_tracker->ChangeList(); }
         
+    /** Whether evaluation differences are cached in the dirty set */
+    bool UseDifferences() const { return m_differences; }
+
+    /** Dirty set, including the journal of changed moves */
+    const RlDirtySet& GetDirtySet() const { return m_dirty; }
+
     /** Check whether specified move is dirty */
     bool IsDirty(SgMove move, SgBlackWhite colour) const 
     { 
@@ -99,6 +109,9 @@ public:
 
 protected:
 
+    /** Prefetch weights[indices[i]] at the precision of the weight set */
+    void PrefetchWeights(const int* indices, int n) const;
+
     void AddWeights(const RlChangeList& changes, RlFloat& eval);
     void SubWeights(const RlChangeList& changes, RlFloat& eval);
     void AddWeightsUpdateActive(const RlChangeList& changes, RlFloat& eval);
@@ -107,8 +120,48 @@ protected:
     RlFloat EvalMoveSimple(SgMove move, SgBlackWhite colour);
     RlFloat EvalMoveDiffs(SgMove move, SgBlackWhite colour);
 
+    /** Change in evaluation from playing move.
+        Non-capturing moves are evaluated without updating the board */
+    RlFloat EvalMoveChange(SgMove move, SgBlackWhite colour);
+
+    /** Change in evaluation from playing and undoing move on board */
+    RlFloat EvalMovePlay(SgMove move, SgBlackWhite colour);
+
+    /** Add weights for candidate move, using delta cache if enabled */
+    void AddMoveWeights(const RlChangeList& changes, RlFloat& eval);
+
+    /** Cached change in evaluation from replacing one feature by another */
+    RlFloat CachedDelta(int from, int to);
+
+    /** Incrementally update representation for a real move or undo */
+    void ExecuteReal(SgMove move, SgBlackWhite colour);
+    void UndoReal();
+
+    /** Update active set from changes, and recompute the evaluation so 
+        that it reflects any changes to the weights */
+    void UpdateActiveReal(const RlChangeList& changes);
+
+    /** Full rebuild after real moves, if periodic rebuild or verification 
+        is required */
+    void RebuildReal();
+
+    /** Whether move can be evaluated without playing it on the board:
+        it must neither capture stones nor be suicide */
+    bool IsSimpleMove(SgMove move, SgBlackWhite colour) const;
+
 private:
 
+    /** Entry in delta cache, valid while the stamps of both weights
+        and the epoch of the weight set are unchanged */
+    struct DeltaEntry
+    {
+        int m_from;
+        int m_to;
+        unsigned m_stamp;
+        unsigned m_epoch;
+        RlFloat m_delta;
+    };
+
     /** Top-level feature set. Used to create tracker(s) */
     RlBinaryFeatures* m_featureSet;
 
@@ -127,16 +180,33 @@ private:
     /** Whether to support undo */
     bool m_supportUndo;
 
+    /** Log2 of number of entries in the delta cache (0 for no cache).
+        The cache stores the change in evaluation when a feature is replaced
+        by its successor, e.g. when a local shape changes at an anchor point.
+        Entries are invalidated lazily using the weight version stamps. */
+    int m_deltaCacheBits;
+
+    /** Direct-mapped delta cache, indexed by hash of feature pair */
+    std::vector<DeltaEntry> m_deltaCache;
+
+    /** Real moves are executed incrementally. Rebuild the representation
+        from scratch after this many real moves (0 for never) */
+    int m_rebuildInterval;
+
+    /** Number of real moves since last full rebuild */
+    int m_numReal;
+
+    /** Number of real moves that can be undone incrementally */
+    int m_realDepth;
+
     /** Current set of active features */
     RlActiveSet m_active;
 
     /** Current evaluation */
     RlFloat m_eval;
 
-    /** Differences to evaluation for each move. 2 SG_PASS+1*/
-    RlFloat m_diffs[RL_NUM_COLOURS][RL_MAX_MOVES];
-
-    /** Which of the above differences are dirty and need recomputation */
+    /** Differences to evaluation for each move, and which of them are 
+        dirty and need recomputation */
     RlDirtySet m_dirty;
     
     /** Upper bound on the magnitude of evaluations */
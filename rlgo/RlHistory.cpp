@@ -11,6 +11,30 @@ using namespace std;
 
 //----------------------------------------------------------------------------
 
+RlEpisode::RlEpisode(const RlEpisode& episode)
+:   m_length(0)
+{
+    SG_UNUSED(episode);
+    SG_ASSERT(episode.m_length == 0);
+}
+
+RlEpisode& RlEpisode::operator=(const RlEpisode& episode)
+{
+    SG_UNUSED(episode);
+    SG_ASSERT(episode.m_length == 0);
+    Clear();
+    return *this;
+}
+
+RlEpisode::~RlEpisode()
+{
+    for (vector<RlState*>::iterator i_block = m_blocks.begin();
+        i_block != m_blocks.end(); ++i_block)
+        delete [] *i_block;
+}
+
+//----------------------------------------------------------------------------
+
 IMPLEMENT_OBJECT(RlHistory);
 
 RlHistory::RlHistory(GoBoard& board, int capacity)
@@ -44,14 +68,13 @@ void RlHistory::Truncate(int length, int n)
     GetEpisode(n).Truncate(length);
 }
 
-void RlHistory::Resize(int activesize)
+void RlHistory::Allocate()
 {
-    // Only resize when empty
+    // Only allocate when empty
+    // States are allocated on demand, and active sets grow as they are used
     SG_ASSERT(m_numEpisodes == 0);
     RlDebug(RlSetup::VOCAL) << "Creating history... ";
     m_history.resize(m_capacity);
-    for (int i = 0; i < m_capacity; ++i)
-        m_history[i].Resize(activesize);
     RlDebug(RlSetup::VOCAL) << "done\n" ;
 }
 
@@ -14,8 +14,10 @@
 
 //----------------------------------------------------------------------------
 /** Simple sequence of states for each time-step. 
-    Memory is allocated in fixed array of size RL_MAX_TIME, 
-    so that pointers to old states will remain valid (no reallocation). */
+    Memory is allocated on demand in fixed size blocks of states, 
+    so that pointers to old states will remain valid (no reallocation). 
+    Blocks are kept when the episode is cleared, and reused by the next
+    episode stored in the same place. */
 class RlEpisode
 {
 public:
@@ -24,19 +26,23 @@ public:
     :   m_length(0)
     {
     }
+
+    /** Episodes may only be copied when empty, storage is not copied */
+    RlEpisode(const RlEpisode& episode);
+    RlEpisode& operator=(const RlEpisode& episode);
+
+    ~RlEpisode();
     
     RlState& operator[](int index)
     {
-        SG_ASSERT(index < m_length);
-        SG_ASSERT(index < RL_MAX_TIME);
-        return m_data[index];
+        SG_ASSERT(index >= 0 && index < m_length);
+        return m_blocks[index >> BLOCK_SHIFT][index & BLOCK_MASK];
     }
 
     const RlState& operator[](int index) const
     {
-        SG_ASSERT(index < m_length);
-        SG_ASSERT(index < RL_MAX_TIME);
-        return m_data[index];
+        SG_ASSERT(index >= 0 && index < m_length);
+        return m_blocks[index >> BLOCK_SHIFT][index & BLOCK_MASK];
     }
     
     int Size() const
@@ -47,35 +53,40 @@ public:
     void Clear()
     {
         for (int i = 0; i < m_length; ++i)
-            m_data[i].Uninitialise();
+            (*this)[i].Uninitialise();
         m_length = 0;
     }
 
     void Truncate(int length)
     {
         for (int i = length; i < m_length; ++i)
-            m_data[i].Uninitialise();
+            (*this)[i].Uninitialise();
         m_length = length;
     }
     
-    void Resize(int activesize)
-    {
-        for (int i = 0; i < RL_MAX_TIME; ++i)
-            m_data[i].Resize(activesize);
-    }
-
     void AddState(int timestep, SgBlackWhite colour)
     {
         SG_ASSERT(m_length == timestep);
         SG_ASSERT(timestep < RL_MAX_TIME);
-        m_data[timestep].Initialise(timestep, colour);
+        if (timestep == ssize(m_blocks) << BLOCK_SHIFT)
+            m_blocks.push_back(new RlState[BLOCK_SIZE]);
         m_length++;
+        (*this)[timestep].Initialise(timestep, colour);
     }
 
 private:
 
+    enum
+    {
+        BLOCK_SHIFT = 6,
+        BLOCK_SIZE = 1 << BLOCK_SHIFT,
+        BLOCK_MASK = BLOCK_SIZE - 1
+    };
+
     int m_length;
-    RlState m_data[RL_MAX_TIME];
+
+    /** Blocks of BLOCK_SIZE states, allocated as the episode grows */
+    std::vector<RlState*> m_blocks;
 };
 
 //----------------------------------------------------------------------------
@@ -101,8 +112,8 @@ public:
     /** Clear the history after given length, without deallocating memory */
     void Truncate(int length, int n = 0);
 
-    /** Specify size for active sets */
-    void Resize(int activesize);
+    /** Allocate (empty) episodes for full capacity */
+    void Allocate();
     
     /** Add a new state into the current episode */
     void AddState(int timestep, SgBlackWhite colour);
@@ -8,6 +8,7 @@
 
 #include "RlEvaluator.h"
 #include "RlHistory.h"
+#include "RlSimdUtil.h"
 #include "RlUtils.h"
 
 #include <math.h>
@@ -128,16 +129,22 @@ void RlLearningRule::Learn()
     if (!m_updateWeights)
         return;
 
-    for (RlActiveSet::Iterator i_active(m_oldState->Active()); 
-        i_active; ++i_active)
+    const RlActiveSnapshot& active = m_oldState->Active();
+    const int* indices = active.GetIndices();
+    const RlOccur* occurrences = active.GetOccurrences();
+    for (int i = 0; i < active.NumOccupied(); ++i)
     {
-        RlOccur occur = i_active->m_occurrences;
-        RlWeight& weight = 
-            m_weightSet->Get(i_active->m_featureIndex);
-        UpdateWeight(weight, occur);
+        RlWeight weight = m_weightSet->Get(indices[i]);
+        UpdateWeight(weight, occurrences[i]);
     }
 }
 
+RlFloat RlLearningRule::GetEligibility(int featureindex) const
+{
+    SG_UNUSED(featureindex);
+    return 0;
+}
+
 inline void RlLearningRule::UpdateWeight(RlWeight& weight, RlOccur occurrences)
 {
     if (!CheckOnPolicy())
@@ -146,7 +153,7 @@ inline void RlLearningRule::UpdateWeight(RlWeight& weight, RlOccur occurrences)
     RlFloat update = m_stepSize * m_delta * occurrences;
     if (m_mse)
         update *= m_logisticGradient;
-    weight.Weight() += update;
+    weight.AddWeight(update);
     weight.IncCount();
 
     SANITY_CHECK(weight.Weight(), RlWeight::MIN_WEIGHT, RlWeight::MAX_WEIGHT);
@@ -162,7 +169,7 @@ inline void RlLearningRule::UpdateWeight(RlWeight& weight, RlOccur occurrences)
 RlFloat RlLearningRule::ApplyLogistic(RlFloat value) const
 {
     if (m_logistic)
-        return RlMathUtil::Logistic(value);
+        return RlSimdUtil::Logistic(value);
     else
         return value;
 }
@@ -201,7 +208,7 @@ void RlLearningRule::CalcValues()
 void RlLearningRule::CountFeatures()
 {
     RlOccur numfeatures = 0;
-    for (RlActiveSet::Iterator i_active(m_oldState->Active()); 
+    for (RlActiveSnapshot::Iterator i_active(m_oldState->Active()); 
         i_active; ++i_active)
     {
         numfeatures += i_active->m_occurrences * i_active->m_occurrences;
@@ -58,6 +58,9 @@ public:
     /** Update all weights. SetData must be called before Learn each step */
     virtual void Learn();
 
+    /** Eligibility trace of a feature, for rules that use traces */
+    virtual RlFloat GetEligibility(int featureindex) const;
+
     /** Specify whether weights should be updated during learning.
         Can use during separate training and testing stages */
     void SetUpdateWeights(bool update) { m_updateWeights = update; }
@@ -192,14 +195,14 @@ inline bool RlLearningRule::CheckOnPolicy() const
 
 inline int RlLearningRule::TraceID(RlWeight& weight) const
 {
-    return m_weightSet->GetFeatureIndex(&weight);
+    return m_weightSet->GetFeatureIndex(weight);
 }
 
 inline bool RlLearningRule::DoLog(RlWeight& weight) const
 {
     return m_log 
         && m_log->GameLogIsActive()
-        && m_updateTrace->ExistsLog(m_weightSet->GetFeatureIndex(&weight));
+        && m_updateTrace->ExistsLog(m_weightSet->GetFeatureIndex(weight));
 }
 
 //----------------------------------------------------------------------------
@@ -6,9 +6,9 @@
 #include "SgSystem.h"
 #include "GoEyeUtil.h"
 #include "RlMoveFilter.h"
+#include "RlRandomUtil.h"
 #include "RlUtils.h"
 #include "SgPointSetUtil.h"
-#include "SgRandom.h"
 
 using namespace std;
 using namespace SgPointUtil;
@@ -140,7 +140,7 @@ SgMove RlMoveFilter::GetRandomMove(SgBlackWhite colour) const
 
     // First try a random vacant point, which will usually be allowed
     int numvacant = m_vacant.size();
-    int index = SgRandom::Global().Int(numvacant);
+    int index = RlRandomUtil::Int(numvacant);
     list<SgMove>::const_iterator i_vacant = m_vacant.begin();
     advance(i_vacant, index);
     if (ConsiderMove(*i_vacant, colour))
@@ -153,7 +153,7 @@ SgMove RlMoveFilter::GetRandomMove(SgBlackWhite colour) const
     if (moves.empty())
         return SG_PASS;
     else
-        return moves[SgRandom::Global().Int(moves.size())];
+        return moves[RlRandomUtil::Int(moves.size())];
 }
 
 void RlMoveFilter::GetMoveVector(SgBlackWhite colour, 
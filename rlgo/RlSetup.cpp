@@ -8,6 +8,7 @@
 
 #include "RlAgent.h"
 #include "RlSimulator.h"
+#include "RlSimdUtil.h"
 #include "RlUtils.h"
 #include <boost/filesystem/convenience.hpp>
 #include <boost/lexical_cast.hpp>
@@ -36,6 +37,7 @@ RlSetup::RlSetup(GoBoard& board, RlRealAgent* agent)
     m_debugOutput(STD),
     m_debugLevel(VOCAL),
     m_verification(false),
+    m_exactMath(false),
     m_defaultTime(10),
     m_mainAgent(agent),
     m_simAgent(0),
@@ -58,7 +60,7 @@ void RlSetup::LoadSettings(std::istream& settings)
     string inputpath, outputpath, bookfile;
     int numgtp;
     
-    settings >> RlVersion(version, 7, 7);
+    settings >> RlVersion(version, 8, 7);
     settings >> RlSetting<string>("InputPath", inputpath);
     settings >> RlSetting<string>("OutputPath", outputpath);
     settings >> RlSetting<int>("BoardSize", m_boardSize);    
@@ -69,6 +71,8 @@ void RlSetup::LoadSettings(std::istream& settings)
     settings >> RlSetting<int>("DebugOutput", m_debugOutput);
     settings >> RlSetting<int>("DebugLevel", m_debugLevel);
     settings >> RlSetting<bool>("Verification", m_verification);
+    if (version >= 8)
+        settings >> RlSetting<bool>("ExactMath", m_exactMath);
     settings >> RlSetting<int>("DefaultTime", m_defaultTime);
     settings >> RlSetting<RlRealAgent*>("MainAgent", m_mainAgent);
     settings >> RlSetting<RlSimAgent*>("SimAgent", m_simAgent);
@@ -109,6 +113,7 @@ void RlSetup::Initialise()
 {
     create_directories(m_mainPath / m_outputPath);
     m_pointIndex = new RlPointIndex(m_boardSize);
+    RlSimdUtil::SetExactMath(m_exactMath);
 
     if (m_debugOutput == NONE)
     {
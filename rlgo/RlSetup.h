@@ -36,6 +36,9 @@ public:
     virtual void LoadSettings(std::istream& settings);
     virtual void Initialise();
 
+    /** There is only one setup, which is never cloned */
+    virtual bool IsReadOnly() const { return true; }
+
     /** Set root path of RLGO distribution */
     void SetMainPath(const bfs::path& mainpath);
 
@@ -144,6 +147,9 @@ private:
     
     /** Whether to run slow verification code */
     bool m_verification;
+
+    /** Whether to use libm for exp and logistic, rather than fast kernels */
+    bool m_exactMath;
         
     /** Default time control (number of seconds per move)
         If no GTP time settings are provided
@@ -10,11 +10,16 @@
 #include "RlAgent.h"
 #include "RlEvaluator.h"
 #include "RlPolicy.h"
+#include "RlRandomUtil.h"
 #include "RlSetup.h"
 #include "RlTimeControl.h"
 #include "RlFuegoPlayout.h"
+#include "RlWeightMerger.h"
+#include "SgRandom.h"
 
+#include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
 
 using namespace boost;
 using namespace std;
@@ -39,15 +44,24 @@ RlSimulator::RlSimulator(GoBoard& board, RlAgent* agent, int maxgames)
     m_log(false),
     m_record(false),
     m_pondering(false),
+    m_numThreads(1),
+    m_numLanes(1),
+    m_merger(0),
     m_ready(false),
-    m_gameRecorder(board)
+    m_gameRecorder(board),
+    m_threadedMode(eNoSimulation),
+    m_searchTime(0),
+    m_numClaimed(0),
+    m_gameMoves(0),
+    m_gameOver(false),
+    m_gameResign(false)
 {
 }
 
 void RlSimulator::LoadSettings(istream& settings)
 {
     int version;
-    settings >> RlVersion(version, 13, 13);
+    settings >> RlVersion(version, 16, 13);
     settings >> RlSetting<RlAgent*>("Agent", m_agent);
     settings >> RlSetting<int>("ControlMode", m_controlMode);
     settings >> RlSetting<RlTimeControl*>("TimeControl", m_timeControl);
@@ -61,6 +75,12 @@ void RlSimulator::LoadSettings(istream& settings)
     settings >> RlSetting<bool>("Log", m_log);
     settings >> RlSetting<bool>("Record", m_record);
     settings >> RlSetting<bool>("Pondering", m_pondering);
+    if (version >= 14)
+        settings >> RlSetting<int>("NumThreads", m_numThreads);
+    if (version >= 15)
+        settings >> RlSetting<RlWeightMerger*>("Merger", m_merger);
+    if (version >= 16)
+        settings >> RlSetting<int>("NumLanes", m_numLanes);
 }
 
 void RlSimulator::Initialise()
@@ -70,6 +90,16 @@ void RlSimulator::Initialise()
         
     if (m_maxSimMoves > RL_MAX_TIME - 2)
         m_maxSimMoves = RL_MAX_TIME - 2;
+
+    // Changes for merging are recorded in the shared weight set without
+    // locking, so can't be recorded by several threads
+    if (m_merger && m_numThreads > 1)
+        throw SgException("Weight merger can't be used with several threads");
+
+    // Synchronising after a game would change weights under the other 
+    // lanes' games, leaving their incremental evaluations stale
+    if (m_merger && m_numLanes > 1)
+        throw SgException("Weight merger can't be used with several lanes");
 }
 
 void RlSimulator::Simulate()
@@ -80,6 +110,15 @@ void RlSimulator::Simulate()
 
 void RlSimulator::Simulate(int controlmode)
 {
+    if (GetNumThreads() < m_numThreads)
+        CreateWorkers(m_numThreads);
+    if (GetNumLanes() < m_numLanes)
+    {
+        CreateLanes(this, 0);
+        for (int i = 0; i < ssize(m_workers); ++i)
+            CreateLanes(m_workers[i], i + 1);
+    }
+
     // Remember current position for fast resetting
     m_agent->GetEvaluator()->Reset();
     if (m_fastReset)
@@ -95,7 +134,12 @@ void RlSimulator::Simulate(int controlmode)
     if (m_record)
         m_gameRecorder.RecordStart(this);
 
-    switch (controlmode)
+    if ((!m_workers.empty() || !m_lanes.empty()) 
+        && controlmode != eNoSimulation)
+    {
+        SimulateThreaded(controlmode);
+    }
+    else switch (controlmode)
     {
         case eMaxGames:
             SimulateMaxGames();
@@ -115,6 +159,10 @@ void RlSimulator::Simulate(int controlmode)
         m_gameRecorder.RecordEnd();
     DisplayStats();
 
+    // Pondering time differs between processes, so isn't synchronised
+    if (m_merger && controlmode != ePonder)
+        m_merger->Sync();
+
     m_agent->GetEvaluator()->Reset();
     if (m_fastReset)
         m_agent->GetEvaluator()->ClearMark();
@@ -140,6 +188,254 @@ void RlSimulator::SimulatePonder()
         SelfPlayGame();
 }
 
+void RlSimulator::AddWorker(RlSimulator* worker)
+{
+    if (worker == this || &worker->m_board == &m_board)
+        throw SgException("Simulation worker must use its own board");
+    if (worker->m_agent == m_agent)
+        throw SgException("Simulation worker must use its own agent");
+    if (worker->m_agent->GetWeightSet() != m_agent->GetWeightSet())
+        throw SgException("Simulation worker must share weight set");
+    if (m_merger)
+        throw SgException("Weight merger can't be used with several threads");
+    
+    // Logs and game records are written by the calling thread only
+    worker->m_log = false;
+    worker->m_record = false;
+    worker->m_numThreads = 1;
+    worker->m_merger = 0;
+    m_workers.push_back(worker);
+}
+
+void RlSimulator::AddLane(RlSimulator* lane)
+{
+    if (lane == this || &lane->m_board == &m_board)
+        throw SgException("Simulation lane must use its own board");
+    if (lane->m_agent == m_agent)
+        throw SgException("Simulation lane must use its own agent");
+    if (lane->m_agent->GetWeightSet() != m_agent->GetWeightSet())
+        throw SgException("Simulation lane must share weight set");
+    if (m_merger)
+        throw SgException("Weight merger can't be used with several lanes");
+    
+    // Logs and game records are written by the first lane only
+    lane->m_log = false;
+    lane->m_record = false;
+    lane->m_numThreads = 1;
+    lane->m_numLanes = 1;
+    lane->m_merger = 0;
+    m_lanes.push_back(lane);
+}
+
+void RlSimulator::CreateLanes(RlSimulator* sim, int thread)
+{
+    // Lanes are always cloned from this simulator, which holds the settings
+    RlFactory& factory = RlGetFactory();
+    string id = factory.GetID(this);
+    set<string> shared;
+    shared.insert(factory.GetID(m_agent->GetWeightSet()));
+
+    while (sim->GetNumLanes() < m_numLanes)
+    {
+        GoBoard* board = new GoBoard(m_board.Size());
+        factory.AddBoard(board);
+        string suffix = "-" + lexical_cast<string>(thread) 
+            + "." + lexical_cast<string>(sim->GetNumLanes());
+        RlSimulator* lane = dynamic_cast<RlSimulator*>(
+            factory.Clone(id, *board, suffix, shared));
+        SG_ASSERT(lane);
+        sim->AddLane(lane);
+    }
+    RlDebug(RlSetup::VOCAL) << "Simulating " << sim->GetNumLanes()
+        << " lanes on thread " << thread << "\n";
+}
+
+void RlSimulator::CreateWorkers(int numthreads)
+{
+    RlFactory& factory = RlGetFactory();
+    string id = factory.GetID(this);
+    set<string> shared;
+    shared.insert(factory.GetID(m_agent->GetWeightSet()));
+
+    while (GetNumThreads() < numthreads)
+    {
+        GoBoard* board = new GoBoard(m_board.Size());
+        factory.AddBoard(board);
+        string suffix = "-" + lexical_cast<string>(GetNumThreads());
+        RlSimulator* worker = dynamic_cast<RlSimulator*>(
+            factory.Clone(id, *board, suffix, shared));
+        SG_ASSERT(worker);
+        AddWorker(worker);
+    }
+    RlDebug(RlSetup::VOCAL) << "Simulating with " 
+        << GetNumThreads() << " threads\n";
+}
+
+void RlSimulator::SimulateThreaded(int controlmode)
+{
+    m_threadedMode = controlmode;
+    m_numClaimed = 0;
+    if (controlmode == eMaxTime)
+        m_searchTime = m_timeControl->TimeForCurrentMove(
+            RlSetup::Get()->GetTimeRecord());
+    
+    // Each worker gets its own random generator, seeded from the global 
+    // generator so that threaded runs are reproducible up to scheduling
+    thread_group threads;
+    for (int i = 0; i < ssize(m_workers); ++i)
+    {
+        RlSimulator* worker = m_workers[i];
+        CopyBoard(m_board, worker->m_board);
+        worker->m_workerError.clear();
+        unsigned int seed = SgRandom::Global().Int();
+        threads.create_thread(
+            bind(&RlSimulator::WorkerSimulate, worker, this, seed));
+    }
+    
+    PlayClaimedGames(this);
+    threads.join_all();
+    
+    for (int i = 0; i < ssize(m_workers); ++i)
+    {
+        RlSimulator* worker = m_workers[i];
+        if (!worker->m_workerError.empty())
+            throw SgException("Simulation worker failed: " 
+                + worker->m_workerError);
+        MergeStats(*worker);
+    }
+}
+
+void RlSimulator::WorkerSimulate(RlSimulator* master, unsigned int seed)
+{
+    // Exceptions must not escape the thread; they are rethrown by master
+    try
+    {
+        RlRandomUtil::SetThreadSeed(seed);
+        m_agent->GetEvaluator()->Reset();
+        if (m_fastReset)
+            m_agent->GetEvaluator()->SetMark();
+        GoRestoreKoRule restoreKoRule(m_board);
+        m_board.Rules().SetKoRule(GoRules::SIMPLEKO);
+
+        ClearStats();
+        PlayClaimedGames(master);
+
+        m_agent->GetEvaluator()->Reset();
+        if (m_fastReset)
+            m_agent->GetEvaluator()->ClearMark();
+    }
+    catch (const std::exception& e)
+    {
+        m_workerError = e.what();
+    }
+    RlRandomUtil::ClearThreadSeed();
+}
+
+void RlSimulator::PlayClaimedGames(RlSimulator* master)
+{
+    if (!m_lanes.empty())
+    {
+        PlayInterleavedGames(master);
+        return;
+    }
+    for (m_numGames = 0; master->ClaimGame(); ++m_numGames)
+        SelfPlayGame();
+}
+
+inline void RlSimulator::Prefetch()
+{
+    m_agent->GetEvaluator()->Prefetch();
+}
+
+void RlSimulator::PlayInterleavedGames(RlSimulator* master)
+{
+    // Each lane simulates its own games from a copy of the current position.
+    // Lanes advance by one move in turn; before a lane plays its move,
+    // the data for the next lane's move is prefetched, so that its memory 
+    // accesses overlap with this lane's computation.
+    vector<RlSimulator*> lanes(1, this);
+    lanes.insert(lanes.end(), m_lanes.begin(), m_lanes.end());
+    int numlanes = ssize(lanes);
+    for (int i = 1; i < numlanes; ++i)
+    {
+        RlSimulator* lane = lanes[i];
+        CopyBoard(m_board, lane->m_board);
+        lane->m_agent->GetEvaluator()->Reset();
+        if (lane->m_fastReset)
+            lane->m_agent->GetEvaluator()->SetMark();
+        lane->ClearStats();
+    }
+
+    vector<bool> playing(numlanes, false);
+    int numplaying = 0;
+    for (int i = 0; i < numlanes; ++i)
+    {
+        lanes[i]->m_numGames = 0;
+        if (master->ClaimGame())
+        {
+            lanes[i]->StartGame();
+            playing[i] = true;
+            numplaying++;
+        }
+    }
+
+    while (numplaying > 0)
+    {
+        for (int i = 0; i < numlanes; ++i)
+        {
+            if (!playing[i])
+                continue;
+
+            // Prefetch for the next lane that is still playing
+            for (int j = (i + 1) % numlanes; j != i; j = (j + 1) % numlanes)
+            {
+                if (playing[j])
+                {
+                    lanes[j]->Prefetch();
+                    break;
+                }
+            }
+            RlSimulator* lane = lanes[i];
+            if (lane->StepGame())
+                continue;
+            lane->FinishGame();
+            lane->m_numGames++;
+            if (master->ClaimGame())
+                lane->StartGame();
+            else
+            {
+                playing[i] = false;
+                numplaying--;
+            }
+        }
+    }
+
+    for (int i = 1; i < numlanes; ++i)
+    {
+        RlSimulator* lane = lanes[i];
+        lane->m_agent->GetEvaluator()->Reset();
+        if (lane->m_fastReset)
+            lane->m_agent->GetEvaluator()->ClearMark();
+        MergeStats(*lane);
+    }
+}
+
+bool RlSimulator::ClaimGame()
+{
+    mutex::scoped_lock lock(m_claimMutex);
+    switch (m_threadedMode)
+    {
+        case eMaxGames:
+            return m_numClaimed++ < m_maxGames;
+        case eMaxTime:
+            return m_elapsedTime.GetTime() < m_searchTime;
+        case ePonder:
+            return !SgUserAbort();
+        default:
+            return false;
+    }
+}
+
 void RlSimulator::ClearStats()
 {
     m_totalSteps = 0;
@@ -148,11 +444,25 @@ void RlSimulator::ClearStats()
         m_freqs[i] = 0;
 }
 
+void RlSimulator::MergeStats(const RlSimulator& worker)
+{
+    int numgames = m_numGames + worker.m_numGames;
+    if (numgames > 0)
+        m_averageScore = (m_averageScore * m_numGames 
+            + worker.m_averageScore * worker.m_numGames) / numgames;
+    m_numGames = numgames;
+    m_totalSteps += worker.m_totalSteps;
+    for (int i = 0; i <= SG_PASS; ++i)
+        m_freqs[i] += worker.m_freqs[i];
+}
+
 void RlSimulator::DisplayStats()
 {
     double seconds = m_elapsedTime.GetTime();
     RlDebug(RlSetup::VOCAL) << "Simulated " 
-        << m_numGames << " games in " << seconds << " seconds: " 
+        << m_numGames << " games on " << GetNumThreads() 
+        << " threads x " << GetNumLanes()
+        << " lanes in " << seconds << " seconds: " 
         << m_numGames / seconds << " games/second ("
         << m_totalSteps / seconds << " moves/second)\n";
 
@@ -241,28 +551,42 @@ void RlSimulator::PlayOut(int& nummoves, bool& resign)
 void RlSimulator::SelfPlayGame()
 {
     // Self-play current game to completion from current position
-    int nummoves = 0;
-    bool gameover = false;
-    bool resign = false;
-    SgMove move = SG_NULLMOVE;
-    SgBlackWhite toplay = m_board.ToPlay();
+    StartGame();
+    while (StepGame())
+        ;
+    FinishGame();
+}
+
+void RlSimulator::StartGame()
+{
+    m_gameMoves = 0;
+    m_gameOver = false;
+    m_gameResign = false;
     if (m_fuegoPlayout)
         m_fuegoPlayout->OnStart();
     if (m_record)
         m_gameRecorder.RecordVarStart();
-    
-    // Main loop
     m_agent->NewGame();
-    while (!gameover && !Truncate(nummoves))
-    {
-        toplay = m_board.ToPlay();
-        move = SelectAndPlay(toplay, nummoves);
-        resign = (move == SG_RESIGN);
-        gameover = GameOver() || resign;
-        if (!resign)
-            nummoves++;
-    }
+}
+
+bool RlSimulator::StepGame()
+{
+    // Play one move of the main loop, return false when loop is finished
+    if (m_gameOver || Truncate(m_gameMoves))
+        return false;
+    SgBlackWhite toplay = m_board.ToPlay();
+    SgMove move = SelectAndPlay(toplay, m_gameMoves);
+    m_gameResign = (move == SG_RESIGN);
+    m_gameOver = GameOver() || m_gameResign;
+    if (!m_gameResign)
+        m_gameMoves++;
+    return true;
+}
 
+void RlSimulator::FinishGame()
+{
+    int& nummoves = m_gameMoves;
+    bool& resign = m_gameResign;
     if (!resign && m_defaultPolicy && Truncate(nummoves))
         PlayOut(nummoves, resign);
 
@@ -284,6 +608,14 @@ void RlSimulator::SelfPlayGame()
 
     if (m_log)
         StepLog(nummoves, score);
+    // Workers and lanes never have a merger, and a simulator with a merger
+    // never has workers or lanes, so synchronising at an interval of games
+    // can't overlap with other games
+    if (m_merger)
+    {
+        SG_ASSERT(m_workers.empty() && m_lanes.empty());
+        m_merger->EndGame();
+    }
 }
 
 void RlSimulator::StepLog(int nummoves, RlFloat score)
@@ -18,10 +18,12 @@
 #include "SgPoint.h"
 #include "SgTimer.h"
 #include <boost/filesystem/fstream.hpp>
+#include <boost/thread/mutex.hpp>
 
 class RlAgent;
 class RlPolicy;
 class RlFuegoPlayout;
+class RlWeightMerger;
 
 //----------------------------------------------------------------------------
 /** Simple class for recording straight simulations to .sgf file */
@@ -88,6 +90,40 @@ public:
 
     void SetMaxGames(int maxgames) { m_maxGames = maxgames; }
 
+    //-------------------------------------------------------------------------
+    // Threaded simulation
+
+    /** Add a worker that simulates games in its own thread.
+        The worker must use its own board and agent, sharing the weight set
+        of this simulator's agent. Weights are updated by all threads
+        without locking (Hogwild). */
+    void AddWorker(RlSimulator* worker);
+
+    /** Remove all workers */
+    void ClearWorkers() { m_workers.clear(); }
+
+    /** Create workers by cloning this simulator and its agent onto new
+        boards, until the specified number of threads is reached */
+    void CreateWorkers(int numthreads);
+
+    /** Number of threads used for simulation, including calling thread */
+    int GetNumThreads() const { return ssize(m_workers) + 1; }
+
+    //-------------------------------------------------------------------------
+    // Interleaved simulation
+
+    /** Add a lane that simulates games in lockstep with this simulator,
+        on the same thread. Each step of one lane overlaps with memory
+        prefetched for the next lane. The lane must use its own board and 
+        agent, sharing the weight set of this simulator's agent. */
+    void AddLane(RlSimulator* lane);
+
+    /** Remove all lanes */
+    void ClearLanes() { m_lanes.clear(); }
+
+    /** Number of games simulated in lockstep by each thread */
+    int GetNumLanes() const { return ssize(m_lanes) + 1; }
+
 protected:
 
     void InitLog();
@@ -98,10 +134,23 @@ protected:
     void SimulatePonder();
     void Simulate(int controlmode);
 
+    void SimulateThreaded(int controlmode);
+    void WorkerSimulate(RlSimulator* master, unsigned int seed);
+    void PlayClaimedGames(RlSimulator* master);
+    void PlayInterleavedGames(RlSimulator* master);
+    bool ClaimGame();
+
+    void CreateLanes(RlSimulator* sim, int thread);
+    void Prefetch();
+
     void ClearStats();
+    void MergeStats(const RlSimulator& worker);
     void DisplayStats();
 
     void SelfPlayGame();
+    void StartGame();
+    bool StepGame();
+    void FinishGame();
     SgMove SelectAndPlay(SgBlackWhite toplay, int movenum);
     bool GameOver();
     bool Truncate(int nummoves);
@@ -159,6 +208,15 @@ private:
     /** Whether pondering is enabled */
     bool m_pondering;
 
+    /** Number of threads to simulate with (workers are created on demand) */
+    int m_numThreads;
+
+    /** Number of games to simulate in lockstep on each thread */
+    int m_numLanes;
+
+    /** Merge weights with other processes after simulation (if not null) */
+    RlWeightMerger* m_merger;
+
     /** Flag set when pondering is possible */
     bool m_ready;
         
@@ -171,6 +229,32 @@ private:
     SgArray<int, SG_PASS + 1> m_freqs;
     
     RlGameRecorder m_gameRecorder;
+
+    /** Worker simulators, each run in its own thread */
+    std::vector<RlSimulator*> m_workers;
+
+    /** Control mode of current threaded simulation */
+    int m_threadedMode;
+
+    /** Search time of current threaded simulation */
+    double m_searchTime;
+
+    /** Number of games claimed by all threads in threaded simulation */
+    int m_numClaimed;
+
+    /** Protects claiming of games by worker threads */
+    boost::mutex m_claimMutex;
+
+    /** Error message from worker thread (empty if no error) */
+    std::string m_workerError;
+
+    /** Lane simulators, run in lockstep with this one */
+    std::vector<RlSimulator*> m_lanes;
+
+    /** State of the game currently simulated by this simulator */
+    int m_gameMoves;
+    bool m_gameOver;
+    bool m_gameResign;
 };
 
 //----------------------------------------------------------------------------
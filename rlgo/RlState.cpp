@@ -35,11 +35,6 @@ RlState::RlState(int timestep, SgBlackWhite colour)
     ClearBest();
 }
 
-void RlState::Resize(int activesize)
-{
-    m_active.Resize(activesize);
-}
-
 inline void RlState::ClearBest()
 {
     // @todo: not strictly necessary, but makes debugging clearer
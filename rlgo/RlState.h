@@ -40,9 +40,6 @@ public:
     /** Re-initialise this state */
     void Reinitialise();
 
-    /** Resize active sets */
-    void Resize(int activesize);
-
     /** Set this state to be a terminal state with specified reward */
     void SetTerminal(RlFloat score);
 
@@ -55,7 +52,7 @@ public:
     /** Set the move */
     void SetMove(SgMove move);
 
-    /** Set the active features */
+    /** Set the active features, storing a compact copy */
     void SetActive(const RlActiveSet& active);
 
     /** Check whether this state is on-policy */
@@ -108,7 +105,7 @@ public:
         return m_terminal; 
     }
     
-    const RlActiveSet& Active() const
+    const RlActiveSnapshot& Active() const
     { 
         SG_ASSERT(ActiveSet());
         return m_active; 
@@ -168,7 +165,7 @@ private:
     bool m_terminal;
 
     /** Active features in current state */
-    RlActiveSet m_active;
+    RlActiveSnapshot m_active;
 
     /** Reward received */
     RlFloat m_reward;
@@ -221,7 +218,7 @@ inline void RlState::SetMove(SgMove move)
 
 inline void RlState::SetActive(const RlActiveSet& active)
 {
-    m_active = active;
+    m_active.Copy(active);
     m_activeSet = true;
 }
 
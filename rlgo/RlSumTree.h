@@ -0,0 +1,112 @@
+//----------------------------------------------------------------------------
+/** @file RlSumTree.h
+    Binary indexed tree of non-negative weights, for sampling in O(log n)
+*/
+//----------------------------------------------------------------------------
+
+#ifndef RLSUMTREE_H
+#define RLSUMTREE_H
+
+#include "RlMiscUtil.h"
+#include <vector>
+
+//----------------------------------------------------------------------------
+/** Fenwick tree over a fixed number of weights.
+    Supports changing a single weight, the total weight, and finding the
+    index at a given cumulative weight, all in O(log n). Repeated updates
+    accumulate rounding error in the partial sums, so the tree should be
+    rebuilt from the weights occasionally. */
+class RlSumTree
+{
+public:
+
+    RlSumTree(int size = 0)
+    {
+        Resize(size);
+    }
+
+    /** Resize and set all weights to zero */
+    void Resize(int size);
+
+    int Size() const { return m_weights.size(); }
+
+    RlFloat Get(int index) const { return m_weights[index]; }
+
+    /** Set weight of specified index */
+    void Set(int index, RlFloat weight);
+
+    /** Sum of all weights */
+    RlFloat Total() const { return m_total; }
+
+    /** Find index such that the sum of all weights before it is
+        at most target, and the sum including it is above target */
+    int Find(RlFloat target) const;
+
+    /** Recompute partial sums from the weights, in O(n) */
+    void Rebuild();
+
+private:
+
+    /** Weights, and partial sums indexed from 1 */
+    std::vector<RlFloat> m_weights;
+    std::vector<RlFloat> m_sums;
+    RlFloat m_total;
+
+    /** Largest power of two not exceeding size */
+    int m_topBit;
+};
+
+inline void RlSumTree::Resize(int size)
+{
+    m_weights.assign(size, 0);
+    m_sums.assign(size + 1, 0);
+    m_total = 0;
+    for (m_topBit = 1; m_topBit * 2 <= size; m_topBit *= 2)
+        ;
+}
+
+inline void RlSumTree::Set(int index, RlFloat weight)
+{
+    SG_ASSERT(weight >= 0);
+    RlFloat delta = weight - m_weights[index];
+    if (delta == 0)
+        return;
+    m_weights[index] = weight;
+    m_total += delta;
+    for (int i = index + 1; i <= Size(); i += i & -i)
+        m_sums[i] += delta;
+}
+
+inline int RlSumTree::Find(RlFloat target) const
+{
+    int pos = 0;
+    for (int step = m_topBit; step > 0; step >>= 1)
+    {
+        if (pos + step <= Size() && m_sums[pos + step] <= target)
+        {
+            pos += step;
+            target -= m_sums[pos];
+        }
+    }
+    return pos < Size() ? pos : Size() - 1;
+}
+
+inline void RlSumTree::Rebuild()
+{
+    m_total = 0;
+    for (int i = 1; i <= Size(); ++i)
+    {
+        m_sums[i] = m_weights[i - 1];
+        m_total += m_weights[i - 1];
+    }
+    for (int i = 1; i <= Size(); ++i)
+    {
+        int parent = i + (i & -i);
+        if (parent <= Size())
+            m_sums[parent] += m_sums[i];
+    }
+}
+
+//----------------------------------------------------------------------------
+
+#endif // RLSUMTREE_H
@@ -44,6 +44,14 @@ void RlTracker::Undo()
     ClearChanges();
 }
 
+bool RlTracker::ExecuteHypothetical(SgMove move, SgBlackWhite colour)
+{
+    SG_UNUSED(move);
+    SG_UNUSED(colour);
+    ClearChanges();
+    return false;
+}
+
 void RlTracker::UpdateDirty(SgMove move, SgBlackWhite colour, 
     RlDirtySet& dirty)
 {
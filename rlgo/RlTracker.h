@@ -38,6 +38,12 @@ public:
         Called after board is updated */
     virtual void Undo() = 0;
 
+    /** Compute changes for a move without updating the board.
+        Only valid for legal moves that capture no stones.
+        Returns false if the tracker requires the board to be played,
+        in which case the change list is undefined. */
+    virtual bool ExecuteHypothetical(SgMove move, SgBlackWhite colour);
+
     /** Update dirty points for specified move */
     virtual void UpdateDirty(SgMove move, SgBlackWhite colour,
         RlDirtySet& dirty);
@@ -10,6 +10,7 @@
 #include "RlEvaluator.h"
 #include "RlHistory.h"
 #include "RlLearningRule.h"
+#include "RlRandomUtil.h"
 
 using namespace std;
 
@@ -67,7 +68,7 @@ int RlTrainer::SelectEpisode(int replay)
         case EP_LAST:
             return replay % m_history->GetNumEpisodes();
         case EP_RANDOM:
-            return SgRandom::Global().Int(
+            return RlRandomUtil::Int(
                 m_history->GetNumEpisodes());
         default:
             throw SgException("Unknown case for selecting episodes");
@@ -93,7 +94,7 @@ void RlEpisodicTrainer::Train()
     {
         int offset = 0;
         if (!m_interleave && m_temporalDifference > 1)
-            offset = SgRandom::Global().Int(m_temporalDifference);
+            offset = RlRandomUtil::Int(m_temporalDifference);
 
         int episode = SelectEpisode(i);
         m_learningRule->Start(m_history, episode);
@@ -179,7 +180,7 @@ void RlRandomTrainer::Train()
     {
         // Select a random transition from the history
         int episode = SelectEpisode(i);
-        int t1 = SgRandom::Global().Range(start,
+        int t1 = RlRandomUtil::Range(start,
             m_history->GetLength(episode));
         int t2 = t1 + m_temporalDifference;
         if (m_history->GetState(t1).Terminal())
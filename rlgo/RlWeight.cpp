@@ -32,59 +32,91 @@ const RlFloat RlWeight::MAX_WEIGHT = +1000;
 const RlFloat RlWeight::MIN_WEIGHT = -1000;
 
 #ifndef RL_ELIGIBILITY
-RlFloat RlWeight::m_eligibility;
-bool RlWeight::m_active = false;
+RlFloat RlWeight::s_eligibility;
+bool RlWeight::s_active = false;
 #endif // RL_ELIGIBILITY
 
 #ifndef RL_STEP
-RlFloat RlWeight::m_step;
+RlFloat RlWeight::s_step;
 #endif // RL_STEP
 
 #ifndef RL_TRACE
-RlFloat RlWeight::m_trace;
+RlFloat RlWeight::s_trace;
 #endif // RL_TRACE
 
 #ifndef RL_COUNT
-int RlWeight::m_count = 0;
+int RlWeight::s_count = 0;
 #endif // RL_COUNT
 
-RlWeight::RlWeight()
+void RlWeight::Clear(bool clearweight)
 {
-    m_active = false;
-    Clear();
-}
-
-void RlWeight::Clear()
-{
-    m_weight = 0;
+    if (clearweight)
+        SetWeight(0);
     #ifdef RL_ELIGIBILITY
-    m_eligibility = 0;
-    m_active = false;
+    Eligibility() = 0;
+    Active() = false;
     #endif
     #ifdef RL_STEP
-    m_step = 1;
+    Step() = 1;
     #endif
     #ifdef RL_TRACE
-    m_trace = 0;
+    Trace() = 0;
     #endif
     #ifdef RL_COUNT
-    m_count = 0;
+    ResetCount();
     #endif
 }
 
-void RlWeight::Save(ostream& ostr)
+void RlWeight::Save(ostream& ostr) const
 {
-    WriteValue<float>(ostr, m_weight);
+    WriteValue<float>(ostr, Weight());
 }
 
 void RlWeight::Load(istream& istr)
 {
-    m_weight = ReadValue<float>(istr);
+    SetWeight(ReadValue<float>(istr));
+}
+
+void RlWeight::Add(const RlWeight& weight, RlFloat mul)
+{
+    AddWeight(weight.Weight() * mul);
+}
+
+void RlWeight::AllocateArrays(RlWeightArrays& arrays, int numweights,
+    RlFloat* weights, bool single)
+{
+    arrays.m_weight = weights ? weights : new RlFloat[numweights];
+    if (single)
+        arrays.m_single = new float[numweights];
+    #ifdef RL_ELIGIBILITY
+    arrays.m_eligibility = new RlFloat[numweights];
+    arrays.m_active = new bool[numweights];
+    #endif
+    #ifdef RL_STEP
+    arrays.m_step = new RlFloat[numweights];
+    #endif
+    #ifdef RL_TRACE
+    arrays.m_trace = new RlFloat[numweights];
+    #endif
+    #ifdef RL_COUNT
+    arrays.m_count = new int[numweights];
+    #endif
 }
 
-void RlWeight::Add(RlWeight& weight, RlFloat mul)
+void RlWeight::FreeArrays(RlWeightArrays& arrays, bool ownweights)
 {
-    m_weight += weight.m_weight * mul;
+    if (ownweights)
+        delete [] arrays.m_weight;
+    delete [] arrays.m_eligibility;
+    delete [] arrays.m_active;
+    delete [] arrays.m_step;
+    delete [] arrays.m_trace;
+    delete [] arrays.m_count;
+    delete [] arrays.m_single;
+    delete [] arrays.m_stamp;
+    delete [] arrays.m_changed;
+    delete [] arrays.m_isChanged;
+    arrays = RlWeightArrays();
 }
 
 void RlWeight::EnsureEligibility()
@@ -7,6 +7,7 @@
 #ifndef RLWEIGHT_H
 #define RLWEIGHT_H
 
+#include "RlProcessUtil.h"
 #include "RlUtils.h"
 
 //----------------------------------------------------------------------------
@@ -29,50 +30,155 @@
 //#define RL_COUNT
 
 //----------------------------------------------------------------------------
-/** Simple class holding the learning parameters for a single feature
+/** Parallel arrays holding the weights and learning parameters of a weight 
+    set. The weights are stored contiguously, separately from the learning
+    parameters, so that evaluation only touches the weight array. 
+    Arrays for undefined properties are not allocated. 
+    Optionally, a single precision copy of the weights is kept for fast
+    evaluation, while learning uses the double precision master weights. 
+    Optionally, each weight has a version stamp that is incremented whenever
+    the weight is set, so that cached functions of the weights can be 
+    invalidated lazily. Bulk changes increment the epoch instead. 
+    Weights that are shared with other processes are incremented 
+    atomically. 
+    Optionally, the indices of all weights set since the last 
+    synchronisation are recorded, so that sparse deltas can be exchanged 
+    with other processes. */
+struct RlWeightArrays
+{
+    RlWeightArrays()
+    :   m_weight(0),
+        m_eligibility(0),
+        m_active(0),
+        m_step(0),
+        m_trace(0),
+        m_count(0),
+        m_single(0),
+        m_stamp(0),
+        m_epoch(0),
+        m_atomic(false),
+        m_changed(0),
+        m_numChanged(0),
+        m_isChanged(0)
+    { }
+
+    RlFloat* m_weight;
+    RlFloat* m_eligibility;
+    bool* m_active;
+    RlFloat* m_step;
+    RlFloat* m_trace;
+    int* m_count;
+    float* m_single;
+    unsigned* m_stamp;
+    unsigned m_epoch;
+    bool m_atomic;
+    int* m_changed;
+    int m_numChanged;
+    bool* m_isChanged;
+};
+
+//----------------------------------------------------------------------------
+/** Lightweight handle to the learning parameters for a single feature,
+    stored in the parallel arrays of a weight set.
 */
 class RlWeight
 {
 public:
 
-    RlWeight();
+    RlWeight(RlWeightArrays* arrays, int index)
+    :   m_arrays(arrays),
+        m_index(index)
+    { }
 
     /** Save the weight */
-    void Save(std::ostream& ostr);
+    void Save(std::ostream& ostr) const;
     
     /** Load the weight */
     void Load(std::istream& istr);
 
-    /** Clear all data */
-    void Clear();
+    /** Clear all data (optionally keeping the weight itself) */
+    void Clear(bool clearweight = true);
+
+    /** Feature index of this weight */
+    int Index() const { return m_index; }
 
     //-------------------------------------------------------------------------
     // Main weight
-    const RlFloat& Weight() const { return m_weight; }
-    RlFloat& Weight() { return m_weight; }
-    void Add(RlWeight& weight, RlFloat mul);
+    /** Master weight. Writing directly to the master weight doesn't update
+        the single precision copy or version stamp, use SetWeight/AddWeight
+        instead, or call RlWeightSet::WeightsChanged afterwards. */
+    RlFloat& Weight() const { return m_arrays->m_weight[m_index]; }
+    void Add(const RlWeight& weight, RlFloat mul);
+
+    /** Set weight, keeping single precision copy and stamp up to date */
+    void SetWeight(RlFloat value) const
+    {
+        m_arrays->m_weight[m_index] = value;
+        if (m_arrays->m_single)
+            m_arrays->m_single[m_index] = static_cast<float>(value);
+        if (m_arrays->m_stamp)
+            m_arrays->m_stamp[m_index]++;
+        if (m_arrays->m_isChanged && !m_arrays->m_isChanged[m_index])
+        {
+            m_arrays->m_isChanged[m_index] = true;
+            m_arrays->m_changed[m_arrays->m_numChanged++] = m_index;
+        }
+    }
+
+    /** Increment weight, keeping single precision copy up to date */
+    void AddWeight(RlFloat delta) const
+    {
+        if (m_arrays->m_atomic)
+            RlAtomicAdd(m_arrays->m_weight[m_index], delta);
+        else
+            SetWeight(m_arrays->m_weight[m_index] + delta);
+    }
 
     //-------------------------------------------------------------------------
     // TD Lambda
-    const bool& Active() const { return m_active; }
-    bool& Active() { return m_active; }
+    bool& Active() const
+    { 
+#ifdef RL_ELIGIBILITY
+        return m_arrays->m_active[m_index];
+#else
+        return s_active;
+#endif // RL_ELIGIBILITY
+    }
 
-    const RlFloat& Eligibility() const { return m_eligibility; }
-    RlFloat& Eligibility() { return m_eligibility; }
+    RlFloat& Eligibility() const
+    { 
+#ifdef RL_ELIGIBILITY
+        return m_arrays->m_eligibility[m_index];
+#else
+        return s_eligibility;
+#endif // RL_ELIGIBILITY
+    }
 
     //-------------------------------------------------------------------------
     // Step-size adaptation
-    const RlFloat& Step() const { return m_step; }
-    RlFloat& Step() { return m_step; }
+    RlFloat& Step() const
+    {
+#ifdef RL_STEP
+        return m_arrays->m_step[m_index];
+#else
+        return s_step;
+#endif // RL_STEP
+    }
 
-    const RlFloat& Trace() const { return m_trace; }
-    RlFloat& Trace() { return m_trace; }
+    RlFloat& Trace() const
+    {
+#ifdef RL_TRACE
+        return m_arrays->m_trace[m_index];
+#else
+        return s_trace;
+#endif // RL_TRACE
+    }
 
     //-------------------------------------------------------------------------
     // Occurrence counting
-    int Count() const { return m_count; }
-    void IncCount() { m_count ++; }
-    void ResetCount() { m_count = 0; }
+    int Count() const { return CountRef(); }
+    void IncCount() { CountRef()++; }
+    void ResetCount() { CountRef() = 0; }
 
     //-------------------------------------------------------------------------
     // Throw an exception if property isn't defined */
@@ -83,48 +189,52 @@ public:
     static void EnsureDeltaPhi();
     static void EnsureCount();
 
+    /** Allocate parallel arrays for all defined properties */
+    static void AllocateArrays(RlWeightArrays& arrays, int numweights,
+        RlFloat* weights = 0, bool single = false);
+
+    /** Free parallel arrays (except for weights, if not owned) */
+    static void FreeArrays(RlWeightArrays& arrays, bool ownweights = true);
+
     static const RlFloat MIN_WEIGHT;
     static const RlFloat MAX_WEIGHT;
 
 private:
 
-    /** The weight corresponding to specified feature */
-    RlFloat m_weight;
-    
-#ifdef RL_ELIGIBILITY
-    /** The eligibility of this weight for credit assignment */
-    RlFloat m_eligibility;
-    
-    /** Whether this weight is currently eligible for learning */
-    bool m_active;
+    int& CountRef() const
+    {
+#ifdef RL_COUNT
+        return m_arrays->m_count[m_index];
 #else
-    static RlFloat m_eligibility;
-    static bool m_active;
+        return s_count;
+#endif // RL_COUNT
+    }
+
+    /** Arrays of the weight set containing this weight */
+    RlWeightArrays* m_arrays;
+
+    /** Index of this weight in the weight set */
+    int m_index;
+
+    /** Static placeholders for undefined properties */
+#ifndef RL_ELIGIBILITY
+    static RlFloat s_eligibility;
+    static bool s_active;
 #endif // RL_ELIGIBILITY
 
-#ifdef RL_STEP
-    /** Step-size parameter associated with this weight */
-    RlFloat m_step;
-#else
-    static RlFloat m_step;
+#ifndef RL_STEP
+    static RlFloat s_step;
 #endif // RL_STEP
 
-#ifdef RL_TRACE
-    /** Step-size trace parameter */
-    RlFloat m_trace;
-#else
-    static RlFloat m_trace;
+#ifndef RL_TRACE
+    static RlFloat s_trace;
 #endif // RL_TRACE
 
-#ifdef RL_COUNT
-    /** How many times this weight has been updated */
-    int m_count;
-#else
-    static int m_count;
+#ifndef RL_COUNT
+    static int s_count;
 #endif // RL_COUNT
 };
 
 //----------------------------------------------------------------------------
 
 #endif // RLWEIGHT_H
-
@@ -0,0 +1,219 @@
+//----------------------------------------------------------------------------
+/** @file RlWeightMerger.cpp
+    See RlWeightMerger.h
+*/
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+#include "RlWeightMerger.h"
+
+#include "RlProcessUtil.h"
+#include "RlSetup.h"
+#include "RlWeightSet.h"
+#include "SgException.h"
+#include <boost/filesystem/operations.hpp>
+
+using namespace RlPathUtil;
+using namespace std;
+
+//----------------------------------------------------------------------------
+
+IMPLEMENT_OBJECT(RlWeightMerger);
+
+RlWeightMerger::RlWeightMerger(GoBoard& board, RlWeightSet* weightset)
+:   RlAutoObject(board),
+    m_weightSet(weightset),
+    m_numProcesses(1),
+    m_interval(0),
+    m_average(true),
+    m_timeout(60),
+    m_process(-1),
+    m_numGames(0),
+    m_listener(0)
+{
+}
+
+RlWeightMerger::~RlWeightMerger()
+{
+    for (int i = 0; i < ssize(m_sockets); ++i)
+        delete m_sockets[i];
+    delete m_listener;
+}
+
+void RlWeightMerger::LoadSettings(istream& settings)
+{
+    settings >> RlSetting<RlWeightSet*>("WeightSet", m_weightSet);
+    settings >> RlSetting<int>("NumProcesses", m_numProcesses);
+    settings >> RlSetting<int>("Interval", m_interval);
+    settings >> RlSetting<bool>("Average", m_average);
+    settings >> RlSetting<string>("SocketName", m_socketName);
+    settings >> RlSetting<double>("Timeout", m_timeout);
+}
+
+void RlWeightMerger::Initialise()
+{
+    m_weightSet->EnsureInitialised();
+    m_process = RlSetup::Get()->GetProcess();
+    if (!Enabled())
+        return;
+    if (m_process >= m_numProcesses)
+        throw SgException("Process number exceeds number of processes");
+
+    m_weightSet->EnableChanges();
+    int numweights = m_weightSet->GetNumFeatures();
+    m_sum.resize(numweights, 0);
+    m_inMerge.resize(numweights, false);
+}
+
+void RlWeightMerger::Connect()
+{
+    // Connect lazily, so that unused mergers never wait for other processes
+    bfs::path socketname = bfs::complete(m_socketName, GetInputPath());
+    int numweights = m_weightSet->GetNumFeatures();
+    if (m_process == 0)
+    {
+        m_listener = new RlListener(socketname);
+        for (int i = 1; i < m_numProcesses; ++i)
+        {
+            m_sockets.push_back(m_listener->Accept());
+            m_sockets.back()->Send(m_weightSet->GetWeights(), 
+                numweights * sizeof(RlFloat));
+        }
+    }
+    else
+    {
+        m_sockets.push_back(new RlSocket);
+        m_sockets.back()->Connect(socketname, m_timeout);
+
+        // Start from the coordinator's weights
+        vector<RlFloat> weights(numweights);
+        m_sockets.back()->Receive(&weights[0], 
+            numweights * sizeof(RlFloat));
+        for (int i = 0; i < numweights; ++i)
+            m_weightSet->GetWeights()[i] = weights[i];
+        m_weightSet->WeightsChanged();
+    }
+
+    RlDebug(RlSetup::VOCAL) << "Connected to " << m_numProcesses - 1 
+        << (m_process == 0 ? " workers" : " coordinator") << "\n";
+}
+
+void RlWeightMerger::EndGame()
+{
+    if (m_interval > 0 && ++m_numGames >= m_interval)
+        Sync();
+}
+
+void RlWeightMerger::Sync()
+{
+    if (!Enabled())
+        return;
+    if (m_sockets.empty())
+    {
+        Connect();
+        m_weightSet->ClearChanges();
+        m_numGames = 0;
+        return;
+    }
+
+    m_indices.clear();
+    for (int i = 0; i < m_weightSet->GetNumChanged(); ++i)
+    {
+        int index = m_weightSet->GetChanged(i);
+        AddDelta(index, m_weightSet->GetChange(index));
+    }
+
+    if (m_process == 0)
+    {
+        for (int i = 0; i < ssize(m_sockets); ++i)
+            ReceiveDelta(m_sockets[i]);
+    
+        RlFloat scale = m_average ? 1.0 / m_numProcesses : 1.0;
+        m_deltas.resize(m_indices.size());
+        for (int i = 0; i < ssize(m_indices); ++i)
+            m_deltas[i] = m_sum[m_indices[i]] * scale;
+
+        for (int i = 0; i < ssize(m_sockets); ++i)
+            SendDelta(m_sockets[i]);
+    }
+    else
+    {
+        m_deltas.resize(m_indices.size());
+        for (int i = 0; i < ssize(m_indices); ++i)
+            m_deltas[i] = m_sum[m_indices[i]];
+        SendDelta(m_sockets[0]);
+
+        for (int i = 0; i < ssize(m_indices); ++i)
+        {
+            m_sum[m_indices[i]] = 0;
+            m_inMerge[m_indices[i]] = false;
+        }
+        m_indices.clear();
+        ReceiveDelta(m_sockets[0]);
+        m_deltas.resize(m_indices.size());
+        for (int i = 0; i < ssize(m_indices); ++i)
+            m_deltas[i] = m_sum[m_indices[i]];
+    }
+
+    ApplyMerged();
+    m_numGames = 0;
+}
+
+void RlWeightMerger::AddDelta(int index, RlFloat delta)
+{
+    if (!m_inMerge[index])
+    {
+        m_inMerge[index] = true;
+        m_indices.push_back(index);
+    }
+    m_sum[index] += delta;
+}
+
+void RlWeightMerger::SendDelta(RlSocket* socket)
+{
+    int size = m_indices.size();
+    socket->Send(&size, sizeof(size));
+    if (size == 0)
+        return;
+    socket->Send(&m_indices[0], size * sizeof(int));
+    socket->Send(&m_deltas[0], size * sizeof(RlFloat));
+}
+
+void RlWeightMerger::ReceiveDelta(RlSocket* socket)
+{
+    int size;
+    socket->Receive(&size, sizeof(size));
+    if (size == 0)
+        return;
+    vector<int> indices(size);
+    vector<RlFloat> deltas(size);
+    socket->Receive(&indices[0], size * sizeof(int));
+    socket->Receive(&deltas[0], size * sizeof(RlFloat));
+    int numweights = m_weightSet->GetNumFeatures();
+    for (int i = 0; i < size; ++i)
+    {
+        if (indices[i] < 0 || indices[i] >= numweights)
+            throw SgException("Bad weight index in merged delta");
+        AddDelta(indices[i], deltas[i]);
+    }
+}
+
+void RlWeightMerger::ApplyMerged()
+{
+    // Every process moves from the same base by the same merged delta
+    for (int i = 0; i < ssize(m_indices); ++i)
+    {
+        int index = m_indices[i];
+        m_weightSet->Get(index).SetWeight(
+            m_weightSet->GetBase(index) + m_deltas[i]);
+        m_sum[index] = 0;
+        m_inMerge[index] = false;
+    }
+    m_weightSet->ClearChanges();
+
+    RlDebug(RlSetup::VOCAL) << "Merged " << m_indices.size() 
+        << " weights\n";
+    m_indices.clear();
+}
+
+//----------------------------------------------------------------------------
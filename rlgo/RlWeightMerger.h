@@ -0,0 +1,104 @@
+//----------------------------------------------------------------------------
+/** @file RlWeightMerger.h
+    Merge weight changes between root-parallel learning processes
+*/
+//----------------------------------------------------------------------------
+
+#ifndef RLWEIGHTMERGER_H
+#define RLWEIGHTMERGER_H
+
+#include "RlUtils.h"
+#include <vector>
+
+class RlListener;
+class RlSocket;
+class RlWeightSet;
+
+//----------------------------------------------------------------------------
+/** Periodically merge the weights of processes that learn into private 
+    copies of a weight set.
+    At each synchronisation, every process sends a sparse delta, containing
+    only the weights changed since the last synchronisation, to process 0. 
+    The coordinator sums or averages all deltas, and sends the merged delta 
+    back to every process, so that all processes continue from the same 
+    weights. Processes are connected by Unix domain sockets.
+    Synchronisation blocks until all processes have sent their deltas, so 
+    all processes must synchronise the same number of times. Synchronising 
+    at an interval of games therefore requires all processes to simulate 
+    the same number of games per move, without pondering. 
+    The first synchronisation connects the processes and copies the 
+    weights of the coordinator to all workers. */
+class RlWeightMerger : public RlAutoObject
+{
+public:
+
+    DECLARE_OBJECT(RlWeightMerger);
+
+    RlWeightMerger(GoBoard& board, RlWeightSet* weightset = 0);
+    ~RlWeightMerger();
+
+    virtual void LoadSettings(std::istream& settings);
+    virtual void Initialise();
+
+    /** Call at the end of each game, synchronises at specified interval */
+    void EndGame();
+
+    /** Synchronise weights with all other processes */
+    void Sync();
+
+    /** Whether merging is enabled for this process */
+    bool Enabled() const { return m_numProcesses > 1 && m_process >= 0; }
+
+    /** Merger is never copied, each process has one connection */
+    virtual bool IsShared() const { return true; }
+
+protected:
+
+    void Connect();
+    void ReceiveDelta(RlSocket* socket);
+    void SendDelta(RlSocket* socket);
+    void AddDelta(int index, RlFloat delta);
+    void ApplyMerged();
+
+private:
+
+    /** Weight set to merge */
+    RlWeightSet* m_weightSet;
+
+    /** Total number of processes, including the coordinator */
+    int m_numProcesses;
+
+    /** Number of games between synchronisations (0 = only when called) */
+    int m_interval;
+
+    /** Average deltas (otherwise deltas are summed) */
+    bool m_average;
+
+    /** Name of socket, relative to input path */
+    std::string m_socketName;
+
+    /** Maximum time to wait for coordinator when connecting */
+    double m_timeout;
+
+    /** Process number of this process (0 is the coordinator) */
+    int m_process;
+
+    /** Games since last synchronisation */
+    int m_numGames;
+
+    /** Listening socket (coordinator only) */
+    RlListener* m_listener;
+
+    /** Connections to other processes (one to coordinator for workers) */
+    std::vector<RlSocket*> m_sockets;
+
+    /** Merged delta: sparse list of indices, and dense accumulators */
+    std::vector<int> m_indices;
+    std::vector<RlFloat> m_deltas;
+    std::vector<RlFloat> m_sum;
+    std::vector<bool> m_inMerge;
+};
+
+//----------------------------------------------------------------------------
+
+#endif // RLWEIGHTMERGER_H
@@ -25,12 +25,13 @@ RlWeightSet::RlWeightSet(GoBoard& board,
     RlBinaryFeatures* featureset)
 :   RlAutoObject(board),
     m_featureSet(featureset),
-    m_weights(0),
     m_numFeatures(0),
     m_numWeights(0),
     m_sharedMemory(0),
     m_strict(true),
-    m_streamMode(0)
+    m_streamMode(0),
+    m_singlePrecision(false),
+    m_base(0)
 {
 }
 
@@ -40,6 +41,7 @@ void RlWeightSet::LoadSettings(istream& settings)
     settings >> RlSetting<string>("ShareName", m_shareName);
     settings >> RlSetting<bool>("Strict", m_strict);
     settings >> RlSetting<int>("StreamMode", m_streamMode);
+    settings >> RlSetting<bool>("SinglePrecision", m_singlePrecision);
 }
 
 void RlWeightSet::Initialise()
@@ -50,50 +52,130 @@ void RlWeightSet::Initialise()
 
     if (m_shareName == "" || m_shareName == "NULL")
     {
-        m_weights = new RlWeight[m_numWeights];
+        RlWeight::AllocateArrays(m_arrays, m_numWeights, 0, 
+            m_singlePrecision);
         m_sharedMemory = 0;    
     }
     else
     {
-        int bytes = m_numWeights * sizeof(RlWeight);
+        if (m_singlePrecision)
+            throw SgException("Single precision weights can't be shared");
+
+        // Only the weights are shared, learning parameters are private
+        int bytes = m_numWeights * sizeof(RlFloat);
         bfs::path pathname = bfs::complete(m_shareName, GetInputPath());
-        m_sharedMemory = new RlSharedMemory(pathname, 0, bytes);
-        m_weights = (RlWeight*) m_sharedMemory->GetData();    
+        m_sharedMemory = new RlSharedMemory(pathname, bytes);
+        RlWeight::AllocateArrays(m_arrays, m_numWeights, 
+            (RlFloat*) m_sharedMemory->GetData(), m_singlePrecision);
+        m_arrays.m_atomic = true;
+        RlDebug(RlSetup::VOCAL) << "Attached to shared weights " 
+            << pathname.native_file_string() << " (" 
+            << m_sharedMemory->GetNumAttached() << " processes)\n";
+    }
+
+    // Don't clear weights of other processes. 
+    // Newly created shared memory is already zeroed.
+    for (int i = 0; i < m_numWeights; ++i)
+        Get(i).Clear(m_sharedMemory == 0);
+}
+
+void RlWeightSet::WeightsChanged()
+{
+    m_arrays.m_epoch++;
+
+    // Bulk changes (e.g. resetting weights) become the new base
+    if (m_base)
+    {
+        for (int i = 0; i < m_arrays.m_numChanged; ++i)
+            m_arrays.m_isChanged[m_arrays.m_changed[i]] = false;
+        m_arrays.m_numChanged = 0;
+        for (int i = 0; i < m_numWeights; ++i)
+            m_base[i] = m_arrays.m_weight[i];
+    }
+
+    if (!m_singlePrecision)
+        return;
+    for (int i = 0; i < m_numWeights; ++i)
+        m_arrays.m_single[i] = static_cast<float>(m_arrays.m_weight[i]);
+}
+
+void RlWeightSet::EnableStamps()
+{
+    // Weights written by other processes wouldn't update the stamps
+    if (m_sharedMemory)
+        throw SgException("Version stamps can't be used with shared weights");
+    if (m_arrays.m_stamp)
+        return;
+    m_arrays.m_stamp = new unsigned[m_numWeights];
+    for (int i = 0; i < m_numWeights; ++i)
+        m_arrays.m_stamp[i] = 0;
+}
+
+void RlWeightSet::EnableChanges()
+{
+    if (m_sharedMemory)
+        throw SgException("Changes can't be recorded for shared weights");
+    if (m_base)
+        return;
+    m_base = new RlFloat[m_numWeights];
+    m_arrays.m_changed = new int[m_numWeights];
+    m_arrays.m_isChanged = new bool[m_numWeights];
+    m_arrays.m_numChanged = 0;
+    for (int i = 0; i < m_numWeights; ++i)
+    {
+        m_base[i] = m_arrays.m_weight[i];
+        m_arrays.m_isChanged[i] = false;
+    }
+}
+
+void RlWeightSet::ClearChanges()
+{
+    SG_ASSERT(m_base);
+    for (int i = 0; i < m_arrays.m_numChanged; ++i)
+    {
+        int index = m_arrays.m_changed[i];
+        m_base[index] = m_arrays.m_weight[index];
+        m_arrays.m_isChanged[index] = false;
     }
+    m_arrays.m_numChanged = 0;
 }
 
 RlWeightSet::~RlWeightSet()
 {
+    RlWeight::FreeArrays(m_arrays, m_sharedMemory == 0);
+    delete [] m_base;
     if (m_sharedMemory)
         delete m_sharedMemory;
-    else if (m_weights)
-        delete [] m_weights;
 }
 
 void RlWeightSet::ZeroWeights()
 {
     for (int i = 0; i < m_numFeatures; ++i)
-        Get(i).Weight() = 0;
+        m_arrays.m_weight[i] = 0;
+    WeightsChanged();
 }
 
 void RlWeightSet::RandomiseWeights(RlFloat min, RlFloat max)
 {
     for (int i = 0; i < m_numFeatures; ++i)
-        Get(i).Weight() = SgRandomFloat(min, max);
+        m_arrays.m_weight[i] = SgRandomFloat(min, max);
+    WeightsChanged();
 }
 
 void RlWeightSet::AddWeights(RlWeightSet* source)
 {
     SG_ASSERT(source->m_numWeights == m_numWeights);
     for (int i = 0; i < m_numFeatures; ++i)
-        Get(i).Weight() += source->Get(i).Weight();
+        m_arrays.m_weight[i] += source->m_arrays.m_weight[i];
+    WeightsChanged();
 }
 
 void RlWeightSet::SubWeights(RlWeightSet* source)
 {
     SG_ASSERT(source->m_numWeights == m_numWeights);
     for (int i = 0; i < m_numFeatures; ++i)
-        Get(i).Weight() -= source->Get(i).Weight();
+        m_arrays.m_weight[i] -= source->m_arrays.m_weight[i];
+    WeightsChanged();
 }
 
 void RlWeightSet::Save(ostream& wstream)
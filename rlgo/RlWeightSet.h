@@ -40,18 +40,72 @@ public:
     /** Subtract weights from another weight set */
     void SubWeights(RlWeightSet* source);
 
-    /** Get a weight (non-const access) */
-    RlWeight& Get(int featureindex)
+    /** Get a handle to a weight and its learning parameters */
+    RlWeight Get(int featureindex) const
     { 
-        return m_weights[featureindex];
+        SG_ASSERT(featureindex >= 0 && featureindex < m_numFeatures);
+        return RlWeight(&m_arrays, featureindex);
     }
 
-    /** Get a weight (const access) */
-    const RlWeight& Get(int featureindex) const
+    /** Get the value of a weight, touching only the weight array */
+    RlFloat GetWeight(int featureindex) const
+    {
+        SG_ASSERT(featureindex >= 0 && featureindex < m_numFeatures);
+        return m_arrays.m_weight[featureindex];
+    }
+
+    /** Contiguous array of all weights */
+    const RlFloat* GetWeights() const { return m_arrays.m_weight; }
+    RlFloat* GetWeights() { return m_arrays.m_weight; }
+
+    /** Whether a single precision copy of the weights is maintained */
+    bool SinglePrecision() const { return m_singlePrecision; }
+
+    /** Contiguous array of single precision weights, used for evaluation */
+    const float* GetSingleWeights() const 
     { 
-        return m_weights[featureindex];
+        SG_ASSERT(m_singlePrecision);
+        return m_arrays.m_single; 
+    }
+
+    /** Copy all master weights into the single precision copy, and 
+        invalidate all version stamps.
+        Must be called after writing to master weights directly. */
+    void WeightsChanged();
+
+    /** Maintain a version stamp for each weight (see RlWeightArrays) */
+    void EnableStamps();
+
+    /** Version stamp of each weight, or null if stamps aren't enabled */
+    const unsigned* GetStamps() const { return m_arrays.m_stamp; }
+
+    /** Epoch of all stamps, incremented by bulk changes to the weights */
+    unsigned GetEpoch() const { return m_arrays.m_epoch; }
+
+    //-------------------------------------------------------------------------
+    // Sparse changes since last synchronisation with other processes
+
+    /** Record weights that are set, and keep a base copy of all weights */
+    void EnableChanges();
+
+    /** Number of weights set since last call to ClearChanges */
+    int GetNumChanged() const { return m_arrays.m_numChanged; }
+
+    /** Feature index of i'th changed weight */
+    int GetChanged(int i) const { return m_arrays.m_changed[i]; }
+
+    /** Change in weight since last call to ClearChanges */
+    RlFloat GetChange(int featureindex) const
+    {
+        return m_arrays.m_weight[featureindex] - m_base[featureindex];
     }
 
+    /** Base value of weight at last call to ClearChanges */
+    RlFloat GetBase(int featureindex) const { return m_base[featureindex]; }
+
+    /** Accept all changes into the base weights */
+    void ClearChanges();
+
     /** Total number of input features */
     int GetNumFeatures() const { return m_numFeatures; }
     
@@ -62,9 +116,9 @@ public:
     void Save(std::ostream& wstream);
     
     /** Get feature index of specified weight */
-    int GetFeatureIndex(const RlWeight* weight) const
+    int GetFeatureIndex(const RlWeight& weight) const
     {
-        int index = weight - m_weights;
+        int index = weight.Index();
         SG_ASSERT(index >= 0 && index < m_numFeatures);
         return index;
     }
@@ -72,13 +126,20 @@ public:
 private:
 
     RlBinaryFeatures* m_featureSet;
-    RlWeight* m_weights;
+
+    /** Weights and learning parameters, stored as parallel arrays.
+        Mutable so that const access can return weight handles. */
+    mutable RlWeightArrays m_arrays;
     int m_numFeatures;
     int m_numWeights;
     std::string m_shareName;
     RlSharedMemory* m_sharedMemory;
     bool m_strict;
     int m_streamMode; // deprecated
+    bool m_singlePrecision;
+
+    /** Weights at last synchronisation (null if changes aren't recorded) */
+    RlFloat* m_base;
 };
 
 //----------------------------------------------------------------------------
@@ -227,7 +227,7 @@ void RlCommands::DescribeFeature(GtpCommand& cmd, int featureindex)
 
     // Use status bar for value (not associated with any point)
     RlWeightSet* wset = m_agent->GetWeightSet();
-    RlWeight& weight = wset->Get(featureindex);
+    RlWeight weight = wset->Get(featureindex);
     if (m_stepSize)
         cmd << " Step = " << weight.Step() <<"\n";
     else
@@ -250,7 +250,7 @@ void RlCommands::AllActive(vector<RlChange>& entries)
     entries.clear();
     RlState& state = Agent()->GetState();
     state.SetActive(Agent()->GetEvaluator()->Active());
-    for (RlActiveSet::Iterator i_active(state.Active());
+    for (RlActiveSnapshot::Iterator i_active(state.Active());
         i_active; ++i_active)
     {
         RlChange entry;
@@ -280,8 +280,8 @@ void RlCommands::CmdActiveAll(GtpCommand& cmd)
 bool RlCommands::EntryCmp::operator()(
     const RlChange& lhs, const RlChange& rhs) const
 {
-    const RlWeight& weight1 = m_weightSet->Get(lhs.m_featureIndex);
-    const RlWeight& weight2 = m_weightSet->Get(rhs.m_featureIndex);
+    RlWeight weight1 = m_weightSet->Get(lhs.m_featureIndex);
+    RlWeight weight2 = m_weightSet->Get(rhs.m_featureIndex);
     return fabs(weight1.Weight()) > fabs(weight2.Weight());
 }
 
@@ -336,7 +336,7 @@ void RlCommands::CmdActiveWeights(GtpCommand& cmd)
     for (int i = 0; i < ssize(entries); ++i)
     {
         RlChange& entry = entries[i];
-        const RlWeight& weight = wset->Get(entry.m_featureIndex);
+        RlWeight weight = wset->Get(entry.m_featureIndex);
         SgPoint pos = fset->GetPosition(entry.m_featureIndex);
         if (m_stepSize)
             influence.Add(pos, weight.Step());
@@ -445,7 +445,7 @@ void RlCommands::DescribePage(GtpCommand& cmd)
         SgPoint pt = *i_board;
         if (indices[index] >= 0)
         {
-            const RlWeight& weight = wset->Get(indices[index]);
+            RlWeight weight = wset->Get(indices[index]);
             RlFloat val = m_stepSize ? weight.Step() : weight.Weight();
             influence.Set(pt, val);
         }
@@ -14,6 +14,7 @@
 #include "RlSetup.h"
 #include "RlSimulator.h"
 #include "RlTrainer.h"
+#include "RlWeightMerger.h"
 #include "RlWeightSet.h"
 #include "RlLocalShapeConvert.h"
 #include "RlLocalShapeFeatures.h"
@@ -57,6 +58,7 @@ void RlForceLink()
     RlBackwardTrainer::ForceLink();
     RlRandomTrainer::ForceLink();
     RlWeightSet::ForceLink();
+    RlWeightMerger::ForceLink();
     RlLocalShapeFusion::ForceLink();
     RlLocalShapeUnshare::ForceLink();
     RlLocalShapeFeatures::ForceLink();
@@ -71,6 +71,83 @@ BOOST_AUTO_TEST_CASE(RlActiveSetIteratorTest)
     }
 }
 
+BOOST_AUTO_TEST_CASE(RlActiveSetSparseTest)
+{
+    int f1 = 12345;
+    int f2 = 23456;
+
+    RlActiveSet active(1000);
+    BOOST_CHECK_EQUAL(active.NumOccupied(), 0);
+    active.Change(RlChange(999, f1, +1));
+    active.Change(RlChange(7, f2, +1));
+    active.Change(RlChange(500, f1, +1));
+    BOOST_CHECK_EQUAL(active.NumOccupied(), 3);
+    active.Change(RlChange(999, f1, -1));
+    BOOST_CHECK_EQUAL(active.NumOccupied(), 2);
+    BOOST_CHECK(!active.IsActive(999));
+    active.Change(RlChange(999, f2, +2));
+    BOOST_CHECK_EQUAL(active.NumOccupied(), 3);
+
+    int count = 0;
+    RlOccur total = 0;
+    for (RlActiveSet::Iterator i_active(active); i_active; ++i_active)
+    {
+        BOOST_CHECK(active.IsActive(i_active.Slot()));
+        BOOST_CHECK_EQUAL(active.GetFeatureIndex(i_active.Slot()),
+            i_active->m_featureIndex);
+        total += i_active->m_occurrences;
+        count++;
+    }
+    BOOST_CHECK_EQUAL(count, 3);
+    BOOST_CHECK_EQUAL(total, active.GetTotalActive());
+
+    // Packed arrays follow iteration order
+    int pos = 0;
+    for (RlActiveSet::Iterator i_active(active); i_active; ++i_active, ++pos)
+    {
+        BOOST_CHECK_EQUAL(active.GetIndices()[pos], i_active->m_featureIndex);
+        BOOST_CHECK_EQUAL(active.GetOccurrences()[pos], 
+            i_active->m_occurrences);
+    }
+
+    active.Clear();
+    BOOST_CHECK_EQUAL(active.NumOccupied(), 0);
+    BOOST_CHECK(!active.IsActive(7));
+    BOOST_CHECK(!RlActiveSet::Iterator(active));
+}
+
+BOOST_AUTO_TEST_CASE(RlActiveSnapshotTest)
+{
+    RlActiveSet active(1000);
+    active.Change(RlChange(999, 12345, +1));
+    active.Change(RlChange(7, 23456, +2));
+
+    RlActiveSnapshot snapshot;
+    snapshot.Copy(active);
+    BOOST_CHECK_EQUAL(snapshot.NumOccupied(), 2);
+    BOOST_CHECK_EQUAL(snapshot.GetTotalActive(), 3);
+
+    RlActiveSnapshot::Iterator i_snapshot(snapshot);
+    for (RlActiveSet::Iterator i_active(active); i_active; 
+        ++i_active, ++i_snapshot)
+    {
+        BOOST_CHECK(i_snapshot);
+        BOOST_CHECK_EQUAL(i_snapshot.Slot(), i_active.Slot());
+        BOOST_CHECK_EQUAL(i_snapshot->m_featureIndex, 
+            i_active->m_featureIndex);
+        BOOST_CHECK_EQUAL(i_snapshot->m_occurrences, 
+            i_active->m_occurrences);
+    }
+    BOOST_CHECK(!i_snapshot);
+
+    // Snapshot is independent of later changes
+    active.Change(RlChange(7, 23456, -2));
+    BOOST_CHECK_EQUAL(snapshot.NumOccupied(), 2);
+    snapshot.Copy(active);
+    BOOST_CHECK_EQUAL(snapshot.NumOccupied(), 1);
+    BOOST_CHECK_EQUAL(snapshot.GetIndices()[0], 12345);
+}
+
 } // namespace
 
 //----------------------------------------------------------------------------
@@ -22,6 +22,8 @@
 #include "RlWeightSet.h"
 #include "RlTestUtil.h"
 
+#include <sstream>
+
 using namespace std;
 using namespace SgPointUtil;
 using namespace RlShapeUtil;
@@ -156,6 +158,95 @@ BOOST_AUTO_TEST_CASE(RlAlphaBetaTestLadders)
     TestLadders(evaluator, alphabeta);
 }
 
+BOOST_AUTO_TEST_CASE(RlAlphaBetaTestPackHash)
+{
+    // Bounds and the null move are negative, so that all 12 bit fields
+    // must be sign extended when the entry is unpacked
+    const int bounds[] = { -RL_SEARCH_MAX, -1234, -1, 0, 1, 567, 
+        +RL_SEARCH_MAX };
+    const SgMove moves[] = { SG_NULLMOVE, SG_PASS, Pt(1, 1), Pt(19, 19) };
+    const int depths[] = { 0, 1, 100, 2047 };
+    const int generations[] = { 1, 2, 0xffff };
+    const int numbounds = sizeof(bounds) / sizeof(bounds[0]);
+    for (int l = 0; l < numbounds; ++l)
+        for (int u = l; u < numbounds; ++u)
+            for (int m = 0; m < 4; ++m)
+                for (int d = 0; d < 4; ++d)
+                    for (int g = 0; g < 3; ++g)
+                    {
+                        RlAlphaBeta::HashData data, unpacked;
+                        data.m_depth = depths[d];
+                        data.m_lowerBound = bounds[l];
+                        data.m_upperBound = bounds[u];
+                        data.m_bestMove = moves[m];
+                        data.m_generation = generations[g];
+                        RlAlphaBeta::UnpackHash(
+                            RlAlphaBeta::PackHash(data), unpacked);
+                        BOOST_CHECK_EQUAL(unpacked.m_depth, depths[d]);
+                        BOOST_CHECK_EQUAL(unpacked.m_lowerBound, bounds[l]);
+                        BOOST_CHECK_EQUAL(unpacked.m_upperBound, bounds[u]);
+                        BOOST_CHECK_EQUAL(unpacked.m_bestMove, moves[m]);
+                        BOOST_CHECK_EQUAL(unpacked.m_generation, 
+                            generations[g]);
+                    }
+}
+
+/** Settings for two searches that share one evaluator.
+    Parallel search clones its helpers through the factory, so the objects 
+    must be loaded from settings rather than constructed directly. */
+string SearchSettings()
+{
+    ostringstream settings;
+    settings << EvaluatorSettings("AB", false, 0);
+    for (int numthreads = 1; numthreads <= 2; ++numthreads)
+        settings
+            << "Object = RlAlphaBeta\n{\n"
+            << "    ID = ABSearch" << numthreads << "\n"
+            << "    Evaluator = ABEvaluator\n    MaxDepth = 4\n"
+            << "    MaxTime = 1000\n    MaxPredictedTime = 1000\n"
+            << "    HashSize = 65536\n    SortDepth = 2\n"
+            << "    HistoryHeuristic = 1\n    KillerHeuristic = 1\n"
+            << "    NumKillers = 3\n    OpponentKillers = 2\n"
+            << "    CutMargin = 10\n    MaxReductions = 0\n"
+            << "    MaxExtensions = 0\n    EnsureParity = 1\n"
+            << "    PVS = 1\n    BranchPower = 0.25\n"
+            << "    NumThreads = " << numthreads << "\n"
+            << "    LargePages = 0\n}\n\n";
+    return settings.str();
+}
+
+BOOST_AUTO_TEST_CASE(RlAlphaBetaTestThreads)
+{
+    // Without reductions, a search to fixed depth computes the exact 
+    // minimax value. Helper threads only share correct bounds through 
+    // the hash table, so they may change the tree but not the value.
+    RlTestObjects objects(5, SearchSettings());
+    GoBoard& bd = objects.Board();
+    RlWeightSet* weights = objects.Get<RlWeightSet>("ABWeights");
+    RlEvaluator* evaluator = objects.Get<RlEvaluator>("ABEvaluator");
+    RlAlphaBeta* single = objects.Get<RlAlphaBeta>("ABSearch1");
+    RlAlphaBeta* threaded = objects.Get<RlAlphaBeta>("ABSearch2");
+
+    // Small weights, so that evaluations aren't clipped
+    SetTestWeights(*weights, 0.2);
+
+    const SgPoint moves[] = { Pt(3, 3), Pt(2, 3), Pt(3, 2), Pt(4, 4) };
+    evaluator->Reset();
+    for (int i = 0; i <= 4; ++i)
+    {
+        for (int depth = 1; depth <= 4; ++depth)
+        {
+            RlFloat value = RunSearch(*single, depth, false);
+            BOOST_CHECK_EQUAL(RunSearch(*threaded, depth, false), value);
+            BOOST_CHECK_EQUAL(threaded->GetNumThreads(), 2);
+        }
+        if (i < 4)
+            evaluator->PlayExecute(moves[i], bd.ToPlay(), false);
+    }
+    for (int i = 0; i < 4; ++i)
+        evaluator->TakeBackUndo(false);
+}
+
 } // namespace
 
 //----------------------------------------------------------------------------
@@ -12,9 +12,23 @@
 #include "RlEvaluator.h"
 
 #include "RlActiveSet.h"
+#include "RlLocalShapeFeatures.h"
+#include "RlLocalShapeShare.h"
 #include "RlManualFeatures.h"
 #include "RlMoveFilter.h"
+#include "RlProductFeatures.h"
+#include "RlStageFeatures.h"
+#include "RlSumFeatures.h"
+#include "RlToPlayFeatures.h"
 #include "RlWeightSet.h"
+#include "RlTestUtil.h"
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+using namespace std;
+using namespace SgPointUtil;
 
 //----------------------------------------------------------------------------
 
@@ -67,6 +81,289 @@ void TestEvaluator2(RlEvaluator& ev, RlManualFeatureSet& f,
     BOOST_CHECK_CLOSE(eval, 1.2f, tol);
 }
 
+void TestEvaluatorReal(RlEvaluator& ev, RlManualFeatureSet& f,
+    RlWeightSet* w)
+{
+    w->ZeroWeights();
+    f.Clear();
+    f.Set(0, 1);
+    w->Get(0).SetWeight(0.2f);
+    w->Get(1).SetWeight(0.3f);
+    ev.Reset();
+    BOOST_CHECK_CLOSE(ev.Eval(), 0.2f, tol);
+
+    // Real moves are incremental, but pick up new features and weights
+    f.Set(1, 2);
+    w->Get(0).SetWeight(0.5f);
+    ev.PlayExecute(SgPointUtil::Pt(3, 3), SG_BLACK, true);
+    BOOST_CHECK_EQUAL(ev.Active().GetTotalActive(), 3);
+    BOOST_CHECK_CLOSE(ev.Eval(), 1.1f, tol);
+
+    w->Get(1).SetWeight(0.1f);
+    ev.TakeBackUndo(true);
+    BOOST_CHECK_EQUAL(ev.Active().GetTotalActive(), 3);
+    BOOST_CHECK_CLOSE(ev.Eval(), 0.7f, tol);
+}
+
+/** Check that the evaluation of every legal move for the colour to play 
+    equals the evaluation after playing it, and that undo restores the 
+    evaluation. Non-capturing moves are evaluated hypothetically, other
+    moves and trackers without hypothetical support by playing them. */
+void CheckHypothetical(RlEvaluator& ev, GoBoard& bd)
+{
+    RlFloat eval = ev.Eval();
+    SgBlackWhite colour = bd.ToPlay();
+    vector<SgMove> moves;
+    for (GoBoard::Iterator i_board(bd); i_board; ++i_board)
+        if (bd.IsLegal(*i_board, colour))
+            moves.push_back(*i_board);
+    moves.push_back(SG_PASS);
+    for (int i = 0; i < ssize(moves); ++i)
+    {
+        RlFloat hypothetical = ev.EvaluateMove(moves[i], colour);
+        BOOST_CHECK_EQUAL(ev.Eval(), eval);
+        ev.PlayExecute(moves[i], colour, false);
+        BOOST_CHECK(fabs(ev.Eval() - hypothetical) < 1e-9);
+        ev.TakeBackUndo(false);
+        BOOST_CHECK(fabs(ev.Eval() - eval) < 1e-9);
+    }
+}
+
+/** Play a sequence that creates capturing and suicide moves, and check
+    every candidate move in every position */
+void TestHypothetical(GoBoard& bd, RlBinaryFeatures& features)
+{
+    RlWeightSet w(bd, &features);
+    RlMoveFilter mf(bd, true);
+    RlEvaluator ev(bd, &features, &w, &mf);
+    features.EnsureInitialised();
+    w.EnsureInitialised();
+    ev.EnsureInitialised();
+    SetTestWeights(w, 0.5);
+    ev.Reset();
+
+    // White suicide at A1 and E5, black captures at D3
+    const SgMove moves[] = 
+    { 
+        Pt(2, 1), Pt(4, 4), Pt(1, 2), SG_PASS, Pt(3, 4), SG_PASS, 
+        Pt(5, 4), SG_PASS, Pt(4, 5), SG_PASS, Pt(4, 3), Pt(5, 5),
+        SG_PASS, Pt(1, 1)
+    };
+    const int nummoves = sizeof(moves) / sizeof(moves[0]);
+    CheckHypothetical(ev, bd);
+    for (int i = 0; i < nummoves; ++i)
+    {
+        BOOST_REQUIRE(bd.IsLegal(moves[i], bd.ToPlay()));
+        ev.PlayExecute(moves[i], bd.ToPlay(), false);
+        CheckHypothetical(ev, bd);
+    }
+    BOOST_CHECK(bd.IsEmpty(Pt(4, 4)));
+    BOOST_CHECK(bd.IsEmpty(Pt(5, 5)));
+    BOOST_CHECK(bd.IsEmpty(Pt(1, 1)));
+    for (int i = 0; i < nummoves; ++i)
+        ev.TakeBackUndo(false);
+}
+
+BOOST_AUTO_TEST_CASE(RlEvaluatorTestHypothetical)
+{
+    GoBoard bd(5);
+    bd.Rules().SetAllowSuicide(true);
+    RlLocalShapeFeatures shapes1(bd, 1, 1);
+    RlLocalShapeFeatures shapes2(bd, 2, 2);
+    RlLocalShapeShare share(bd, &shapes2);
+    share.UseTableFile(false);
+    RlToPlayFeatures toplay(bd);
+    RlStageFeatures stage(bd, 2);
+
+    // Sum of local shape, shared, to play and stage trackers
+    RlSumFeatures sum(bd);
+    sum.AddFeatureSet(&shapes1);
+    sum.AddFeatureSet(&share);
+    sum.AddFeatureSet(&toplay);
+    sum.AddFeatureSet(&stage);
+    TestHypothetical(bd, sum);
+
+    // Trackers without hypothetical execution fall back to playing moves
+    RlProductFeatures product(bd, &toplay, &shapes1);
+    TestHypothetical(bd, product);
+    RlManualFeatureSet manual(bd, 4);
+    manual.EnsureInitialised();
+    manual.Set(0, 1);
+    manual.Set(2, 3);
+    TestHypothetical(bd, manual);
+}
+
+/** Check that the evaluator with a delta cache agrees with the evaluator
+    without one, for every legal move */
+void CheckDeltaCache(RlEvaluator* cached, RlEvaluator* plain, GoBoard& bd)
+{
+    SgBlackWhite colour = bd.ToPlay();
+    for (GoBoard::Iterator i_board(bd); i_board; ++i_board)
+        if (bd.IsLegal(*i_board, colour))
+            BOOST_CHECK(fabs(cached->EvaluateMove(*i_board, colour)
+                - plain->EvaluateMove(*i_board, colour)) < 1e-9);
+}
+
+/** Change a weight by the same amount in each weight set, with SetWeight
+    or by writing the weight directly */
+void ChangeWeight(RlWeightSet* weights[2], int index, RlFloat delta,
+    bool setweight)
+{
+    for (int i = 0; i < 2; ++i)
+    {
+        RlFloat weight = weights[i]->Get(index).Weight() + delta;
+        if (setweight)
+            weights[i]->Get(index).SetWeight(weight);
+        else
+            weights[i]->Get(index).Weight() = weight;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(RlEvaluatorTestDeltaCache)
+{
+    // Evaluators without and with a delta cache, with identical weights
+    RlTestObjects objects(5, EvaluatorSettings("Plain", false, 0)
+        + EvaluatorSettings("Cached", false, 8));
+    GoBoard& bd = objects.Board();
+    RlWeightSet* weights[2] = 
+    { 
+        objects.Get<RlWeightSet>("PlainWeights"),
+        objects.Get<RlWeightSet>("CachedWeights")
+    };
+    RlEvaluator* plain = objects.Get<RlEvaluator>("PlainEvaluator");
+    RlEvaluator* cached = objects.Get<RlEvaluator>("CachedEvaluator");
+    SetTestWeights(*weights[0], 0.5);
+    SetTestWeights(*weights[1], 0.5);
+    bd.Play(Pt(2, 2), SG_BLACK);
+    bd.Play(Pt(3, 3), SG_WHITE);
+    plain->Reset();
+    cached->Reset();
+    CheckDeltaCache(cached, plain, bd);
+
+    // Find a feature replaced by its successor, with a cached delta
+    SgMove move = Pt(2, 3);
+    cached->EvaluateMove(move, SG_BLACK);
+    const RlChangeList& changes = cached->ChangeList();
+    const int* indices = changes.GetIndices();
+    const RlOccur* occurrences = changes.GetOccurrences();
+    int from = -1, to = -1;
+    for (int i = 0; i + 1 < changes.Size(); ++i)
+    {
+        if (occurrences[i] == -1 && occurrences[i + 1] == +1)
+        {
+            from = indices[i];
+            to = indices[i + 1];
+            break;
+        }
+    }
+    BOOST_REQUIRE(from >= 0 && to >= 0);
+
+    // Setting the weight of either feature bumps its stamp
+    ChangeWeight(weights, from, +0.25, true);
+    CheckDeltaCache(cached, plain, bd);
+    ChangeWeight(weights, to, -0.25, true);
+    CheckDeltaCache(cached, plain, bd);
+
+    // Writing weights directly leaves the stamps unchanged, 
+    // WeightsChanged bumps the epoch
+    ChangeWeight(weights, from, -0.5, false);
+    ChangeWeight(weights, to, +0.5, false);
+    weights[0]->WeightsChanged();
+    weights[1]->WeightsChanged();
+    CheckDeltaCache(cached, plain, bd);
+}
+
+/** Dirty flags and differences of all moves for both colours */
+struct DirtySnapshot
+{
+    DirtySnapshot(const RlDirtySet& dirty, GoBoard& bd)
+    {
+        for (GoBoard::Iterator i_board(bd); i_board; ++i_board)
+            Add(dirty, *i_board);
+        Add(dirty, SG_PASS);
+    }
+
+    void Add(const RlDirtySet& dirty, SgMove move)
+    {
+        for (int c = SG_BLACK; c <= SG_WHITE; ++c)
+        {
+            m_dirty.push_back(dirty.IsDirty(move, c));
+            m_diffs.push_back(dirty.GetDiff(move, c));
+        }
+    }
+
+    vector<bool> m_dirty;
+    vector<RlFloat> m_diffs;
+};
+
+/** Evaluate all legal moves for both colours, refreshing dirty moves */
+void EvaluateAll(RlEvaluator* ev, GoBoard& bd)
+{
+    for (int c = SG_BLACK; c <= SG_WHITE; ++c)
+    {
+        for (GoBoard::Iterator i_board(bd); i_board; ++i_board)
+            if (bd.IsLegal(*i_board, c))
+                ev->EvaluateMove(*i_board, c);
+        ev->EvaluateMove(SG_PASS, c);
+    }
+}
+
+/** Evaluate all moves in every position, and check that each undo 
+    restores exactly the dirty flags and differences before the move */
+class DirtyHooks : public RlRandomGameHooks
+{
+public:
+
+    DirtyHooks(RlEvaluator* ev, GoBoard& bd)
+    :   m_ev(ev), m_bd(bd)
+    {
+    }
+
+    virtual void Position()
+    {
+        EvaluateAll(m_ev, m_bd);
+    }
+
+    virtual void BeforePlay()
+    {
+        m_snapshots.push_back(DirtySnapshot(m_ev->GetDirtySet(), m_bd));
+    }
+
+    virtual void AfterUndo()
+    {
+        DirtySnapshot after(m_ev->GetDirtySet(), m_bd);
+        const DirtySnapshot& before = m_snapshots.back();
+        BOOST_REQUIRE_EQUAL(after.m_dirty.size(), before.m_dirty.size());
+        for (int i = 0; i < ssize(before.m_dirty); ++i)
+        {
+            BOOST_CHECK_EQUAL(after.m_dirty[i], before.m_dirty[i]);
+            BOOST_CHECK(memcmp(&after.m_diffs[i], &before.m_diffs[i],
+                sizeof(RlFloat)) == 0);
+        }
+        m_snapshots.pop_back();
+    }
+
+private:
+
+    RlEvaluator* m_ev;
+    GoBoard& m_bd;
+    vector<DirtySnapshot> m_snapshots;
+};
+
+BOOST_AUTO_TEST_CASE(RlEvaluatorTestDirtyUndo)
+{
+    RlTestObjects objects(5, EvaluatorSettings("Dirty", true, 0));
+    GoBoard& bd = objects.Board();
+    RlWeightSet* weights = objects.Get<RlWeightSet>("DirtyWeights");
+    RlEvaluator* ev = objects.Get<RlEvaluator>("DirtyEvaluator");
+    SetTestWeights(*weights, 0.5);
+    ev->Reset();
+
+    // Play a random game with captures, taking back some moves
+    DirtyHooks hooks(ev, bd);
+    PlayRandomGame(*ev, 12345, 100, 30, hooks);
+}
+
 BOOST_AUTO_TEST_CASE(RlEvaluatorTest)
 {
     GoBoard bd(9);
@@ -80,6 +377,7 @@ BOOST_AUTO_TEST_CASE(RlEvaluatorTest)
 
     TestEvaluator1(ev, f, &w);
     TestEvaluator2(ev, f, &w);
+    TestEvaluatorReal(ev, f, &w);
 }
 
 } // namespace
@@ -0,0 +1,132 @@
+//----------------------------------------------------------------------------
+/** @file RlGibbsTest.cpp
+    Unit tests for RlGibbs
+*/
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+
+#include <boost/test/floating_point_comparison.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/test/auto_unit_test.hpp>
+#include "RlGibbs.h"
+
+#include "RlEvaluator.h"
+#include "RlMoveFilter.h"
+#include "RlState.h"
+#include "RlWeightSet.h"
+#include "RlTestUtil.h"
+
+#include <sstream>
+
+using namespace std;
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+// percentage tolerance for floating point comparison
+const float tol = 0.001f;
+
+/** Settings for full and incremental Gibbs policies sharing one evaluator.
+    The eye filter disallows vacant points, which become allowed again
+    when the eye is broken or its neighbours are captured. */
+string GibbsSettings()
+{
+    ostringstream settings;
+    settings << EvaluatorSettings("Gibbs", true, 0, "RlSimpleEyeFilter");
+    for (int incremental = 0; incremental <= 1; ++incremental)
+        settings
+            << "Object = RlGibbs\n{\n"
+            << "    ID = Gibbs" << incremental << "\n"
+            << "    Version = 3\n    Evaluator = GibbsEvaluator\n"
+            << "    Log = NULL\n    OnPolicy = 1\n"
+            << "    Temperature = 0.5\n    Centre = 1\n    Redraw = 0\n"
+            << "    Incremental = " << incremental << "\n}\n\n";
+    return settings.str();
+}
+
+/** Compare the incremental distribution to the full distribution.
+    Moves that become disallowed without a journal entry (e.g. suicide
+    after a distant liberty is filled) keep their weight in the sum tree
+    until they are sampled, and sampling rejects them. So the incremental
+    distribution is compared after normalising over the allowed moves. */
+void CheckGibbs(GoBoard& bd, const RlMoveFilter* filter,
+    RlGibbs* full, RlGibbs* incremental)
+{
+    SgBlackWhite colour = bd.ToPlay();
+    RlState fullstate(0, colour);
+    RlState incrementalstate(0, colour);
+    full->SelectMove(fullstate);
+    incremental->SelectMove(incrementalstate);
+
+    vector<SgMove> moves;
+    filter->GetMoveVector(colour, moves);
+    BOOST_REQUIRE(!moves.empty());
+    RlFloat total = 0;
+    for (int i = 0; i < ssize(moves); ++i)
+        total += incremental->GetProbability(moves[i]);
+    BOOST_REQUIRE(total > 0);
+
+    RlFloat fulltotal = 0;
+    for (int i = 0; i < ssize(moves); ++i)
+    {
+        RlFloat p = full->GetProbability(moves[i]);
+        BOOST_CHECK_CLOSE(incremental->GetProbability(moves[i]) / total,
+            p, tol);
+        fulltotal += p;
+    }
+    BOOST_CHECK_CLOSE(fulltotal, 1.0, tol);
+
+    // Occupied points never have weight
+    for (GoBoard::Iterator i_board(bd); i_board; ++i_board)
+        if (bd.Occupied(*i_board))
+            BOOST_CHECK_EQUAL(incremental->GetProbability(*i_board), 0);
+}
+
+/** Compare the distributions in every position of a random game */
+class GibbsHooks : public RlRandomGameHooks
+{
+public:
+
+    GibbsHooks(GoBoard& bd, const RlMoveFilter* filter, 
+        RlGibbs* full, RlGibbs* incremental)
+    :   m_bd(bd), m_filter(filter), m_full(full), m_incremental(incremental)
+    {
+    }
+
+    virtual void Position()
+    {
+        CheckGibbs(m_bd, m_filter, m_full, m_incremental);
+    }
+
+private:
+
+    GoBoard& m_bd;
+    const RlMoveFilter* m_filter;
+    RlGibbs* m_full;
+    RlGibbs* m_incremental;
+};
+
+BOOST_AUTO_TEST_CASE(RlGibbsTestIncremental)
+{
+    RlTestObjects objects(7, GibbsSettings());
+    GoBoard& bd = objects.Board();
+    RlWeightSet* weights = objects.Get<RlWeightSet>("GibbsWeights");
+    RlEvaluator* evaluator = objects.Get<RlEvaluator>("GibbsEvaluator");
+    RlGibbs* full = objects.Get<RlGibbs>("Gibbs0");
+    RlGibbs* incremental = objects.Get<RlGibbs>("Gibbs1");
+    const RlMoveFilter* filter = evaluator->GetMoveFilter();
+    SetTestWeights(*weights, 0.5);
+    evaluator->Reset();
+
+    // Play a random game with captures, taking back some moves, and
+    // compare the distributions at every step
+    GibbsHooks hooks(bd, filter, full, incremental);
+    PlayRandomGame(*evaluator, 12345, 150, 20, hooks);
+    CheckGibbs(bd, filter, full, incremental);
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
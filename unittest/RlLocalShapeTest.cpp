@@ -18,6 +18,8 @@
 #include "RlUtils.h"
 #include "RlTestUtil.h"
 
+#include <vector>
+
 using namespace std;
 using namespace SgPointUtil;
 using namespace boost::test_tools;
@@ -240,6 +242,91 @@ BOOST_AUTO_TEST_CASE(RlLocalShapeTrackerTest)
     BOOST_CHECK_EQUAL(active.GetTotalActive(), 14);
 }
 
+/** Tracker that exposes its packed local move lists */
+class LocalMoveTracker : public RlLocalShapeTracker
+{
+public:
+
+    LocalMoveTracker(GoBoard& bd, RlLocalShapeFeatures* shapes)
+    :   RlLocalShapeTracker(bd, shapes, false)
+    {
+    }
+
+    /** (anchor, slot, local move) triples for colour index c at point */
+    void GetLocalMoves(int c, SgPoint point, vector<int>& triples) const
+    {
+        triples.clear();
+        for (int i = m_localStart[c][point]; 
+            i < m_localStart[c][point + 1]; ++i)
+        {
+            triples.push_back(m_localMoves[i].m_anchor);
+            triples.push_back(m_localMoves[i].m_slot);
+            triples.push_back(m_localMoves[i].m_localMove);
+        }
+    }
+};
+
+/** Triples as enumerated by the original per-point lists: every anchor of
+    a shape that covers the point, in order of row then column */
+void ExpectedLocalMoves(const RlLocalShapeFeatures& shapes,
+    int c, SgPoint point, vector<int>& triples)
+{
+    triples.clear();
+    int col = Col(point);
+    int row = Row(point);
+    int xsize = shapes.GetXSize();
+    int ysize = shapes.GetYSize();
+    int xnum = shapes.GetXNum();
+    int ynum = shapes.GetYNum();
+    for (int y = max(1, row - (ysize - 1)); y <= min(row, ynum); ++y)
+    {
+        for (int x = max(1, col - (xsize - 1)); x <= min(col, xnum); ++x)
+        {
+            triples.push_back(Pt(x, y));
+            triples.push_back((y - 1) * xnum + (x - 1));
+            triples.push_back(((row - y) * xsize + (col - x)) * 3 + c);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(RlLocalShapeTrackerTestLocalMoves)
+{
+    const int boardsizes[] = { 9, 19 };
+    for (int i = 0; i < 2; ++i)
+    {
+        GoBoard bd(boardsizes[i]);
+        for (int xsize = 1; xsize <= 3; ++xsize)
+        {
+            for (int ysize = 1; ysize <= 3; ++ysize)
+            {
+                RlLocalShapeFeatures shapes(bd, xsize, ysize);
+                shapes.EnsureInitialised();
+                LocalMoveTracker tracker(bd, &shapes);
+                tracker.Initialise();
+
+                // Off-board points have empty lists
+                vector<bool> onboard(SG_MAXPOINT, false);
+                for (GoBoard::Iterator i_board(bd); i_board; ++i_board)
+                    onboard[*i_board] = true;
+                vector<int> packed, expected;
+                for (int c = 0; c < 3; ++c)
+                {
+                    for (SgPoint p = 0; p < SG_MAXPOINT; ++p)
+                    {
+                        tracker.GetLocalMoves(c, p, packed);
+                        expected.clear();
+                        if (onboard[p])
+                            ExpectedLocalMoves(shapes, c, p, expected);
+                        BOOST_CHECK_EQUAL_COLLECTIONS(
+                            packed.begin(), packed.end(),
+                            expected.begin(), expected.end());
+                    }
+                }
+            }
+        }
+    }
+}
+
 } // namespace
 
 //----------------------------------------------------------------------------
@@ -0,0 +1,215 @@
+//----------------------------------------------------------------------------
+/** @file RlSimdUtilTest.cpp
+    Unit tests for RlSimdUtil.h
+*/
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+
+#include "RlSimdUtil.h"
+
+#include <math.h>
+#include <boost/test/unit_test.hpp>
+#include <boost/test/auto_unit_test.hpp>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+/** Deterministic generator, so that failures are reproducible */
+class TestRandom
+{
+public:
+
+    TestRandom() : m_state(12345) { }
+
+    int Int(int n)
+    {
+        m_state = m_state * 1103515245u + 12345u;
+        return (m_state >> 8) % n;
+    }
+
+    double Uniform(double min, double max)
+    {
+        return min + (max - min) * Int(1 << 20) / (1 << 20);
+    }
+
+private:
+
+    unsigned int m_state;
+};
+
+/** Restore best instruction set when a test finishes */
+struct RestoreInstructionSet
+{
+    ~RestoreInstructionSet()
+    {
+        RlSimdUtil::SetInstructionSet(RlSimdUtil::eAVX512);
+    }
+};
+
+BOOST_AUTO_TEST_CASE(RlSimdUtilInstructionSetTest)
+{
+    RestoreInstructionSet restore;
+    int best = RlSimdUtil::GetInstructionSet();
+    RlSimdUtil::SetInstructionSet(RlSimdUtil::eScalar);
+    BOOST_CHECK_EQUAL(RlSimdUtil::GetInstructionSet(), RlSimdUtil::eScalar);
+    RlSimdUtil::SetInstructionSet(RlSimdUtil::eAVX512);
+    BOOST_CHECK_EQUAL(RlSimdUtil::GetInstructionSet(), best);
+}
+
+BOOST_AUTO_TEST_CASE(RlSimdUtilGatherDotTest)
+{
+    // Every kernel must agree with the scalar kernel up to rounding,
+    // for all lengths including partial vectors
+    RestoreInstructionSet restore;
+    TestRandom random;
+    const int numweights = 10000;
+    vector<double> weights(numweights);
+    vector<float> singles(numweights);
+    for (int i = 0; i < numweights; ++i)
+    {
+        weights[i] = random.Uniform(-1.0, 1.0);
+        singles[i] = static_cast<float>(weights[i]);
+    }
+
+    for (int n = 0; n <= 100; ++n)
+    {
+        vector<int> indices(n + 1), occurrences(n + 1);
+        double magnitude = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            indices[i] = random.Int(numweights);
+            occurrences[i] = random.Int(5) - 2;
+            magnitude += fabs(weights[indices[i]] * occurrences[i]);
+        }
+
+        RlSimdUtil::SetInstructionSet(RlSimdUtil::eScalar);
+        double expected = RlSimdUtil::GatherDot(&weights[0],
+            &indices[0], &occurrences[0], n);
+        float expectedsingle = RlSimdUtil::GatherDot(&singles[0],
+            &indices[0], &occurrences[0], n);
+
+        for (int set = RlSimdUtil::eScalar; set <= RlSimdUtil::eAVX512;
+            ++set)
+        {
+            RlSimdUtil::SetInstructionSet(set);
+            double dot = RlSimdUtil::GatherDot(&weights[0],
+                &indices[0], &occurrences[0], n);
+            float dotsingle = RlSimdUtil::GatherDot(&singles[0],
+                &indices[0], &occurrences[0], n);
+            BOOST_CHECK(fabs(dot - expected) <= 1e-13 * magnitude);
+            BOOST_CHECK(fabs(dotsingle - expectedsingle)
+                <= 1e-5 * magnitude);
+        }
+    }
+}
+
+/** Restore table-driven exponential when a test finishes */
+struct RestoreExactMath
+{
+    ~RestoreExactMath()
+    {
+        RlSimdUtil::SetExactMath(false);
+    }
+};
+
+/** Inputs covering the whole range of exp, including the ends where 
+    the kernels fall back to libm (overflow, denormals and underflow) */
+void ExpInputs(vector<double>& values)
+{
+    values.clear();
+    for (double x = -800.0; x <= 800.0; x += 0.37)
+        values.push_back(x);
+    for (double x = -1.0; x <= 1.0; x += 1.0 / 1024.0)
+        values.push_back(x);
+    values.push_back(-708.0);
+    values.push_back(-708.0 - 1e-9);
+    values.push_back(-745.2);
+    values.push_back(+709.0);
+    values.push_back(+709.0 + 1e-9);
+    values.push_back(+710.0);
+}
+
+inline bool CloseTo(double value, double expected, double tolerance)
+{
+    return value == expected 
+        || fabs(value - expected) <= tolerance * fabs(expected);
+}
+
+BOOST_AUTO_TEST_CASE(RlSimdUtilExpTest)
+{
+    RestoreInstructionSet restore;
+    vector<double> values;
+    ExpInputs(values);
+    int n = values.size();
+    vector<double> results(n);
+    for (int set = RlSimdUtil::eScalar; set <= RlSimdUtil::eAVX512; ++set)
+    {
+        RlSimdUtil::SetInstructionSet(set);
+        RlSimdUtil::Exp(&values[0], &results[0], n);
+        for (int i = 0; i < n; ++i)
+        {
+            BOOST_CHECK(CloseTo(results[i], exp(values[i]), 1e-12));
+            
+            // Scalar and vector kernels give identical results
+            BOOST_CHECK_EQUAL(results[i], RlSimdUtil::Exp(values[i]));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(RlSimdUtilLogisticTest)
+{
+    RestoreInstructionSet restore;
+    vector<double> values;
+    ExpInputs(values);
+    int n = values.size();
+    vector<double> results(n);
+    for (int set = RlSimdUtil::eScalar; set <= RlSimdUtil::eAVX512; ++set)
+    {
+        RlSimdUtil::SetInstructionSet(set);
+        RlSimdUtil::Logistic(&values[0], &results[0], n);
+        for (int i = 0; i < n; ++i)
+        {
+            double expected = 1.0 / (1.0 + exp(-values[i]));
+            BOOST_CHECK(CloseTo(results[i], expected, 1e-12));
+            BOOST_CHECK_EQUAL(results[i], RlSimdUtil::Logistic(values[i]));
+            BOOST_CHECK(results[i] >= 0.0 && results[i] <= 1.0);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(RlSimdUtilExactMathTest)
+{
+    // With exact math, results are bit-exact with libm
+    RestoreInstructionSet restore;
+    RestoreExactMath restoreexact;
+    vector<double> values;
+    ExpInputs(values);
+    int n = values.size();
+    vector<double> results(n);
+    RlSimdUtil::SetExactMath(true);
+    BOOST_CHECK(RlSimdUtil::GetExactMath());
+    for (int set = RlSimdUtil::eScalar; set <= RlSimdUtil::eAVX512; ++set)
+    {
+        RlSimdUtil::SetInstructionSet(set);
+        RlSimdUtil::Exp(&values[0], &results[0], n);
+        for (int i = 0; i < n; ++i)
+        {
+            BOOST_CHECK_EQUAL(results[i], exp(values[i]));
+            BOOST_CHECK_EQUAL(RlSimdUtil::Exp(values[i]), exp(values[i]));
+        }
+        RlSimdUtil::Logistic(&values[0], &results[0], n);
+        for (int i = 0; i < n; ++i)
+            BOOST_CHECK_EQUAL(results[i], 1.0 / (1.0 + exp(-values[i])));
+    }
+    RlSimdUtil::SetExactMath(false);
+    BOOST_CHECK(!RlSimdUtil::GetExactMath());
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
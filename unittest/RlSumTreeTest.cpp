@@ -0,0 +1,124 @@
+//----------------------------------------------------------------------------
+/** @file RlSumTreeTest.cpp
+    Unit tests for RlSumTree
+*/
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/auto_unit_test.hpp>
+#include "RlSumTree.h"
+
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+/** Find by linear search, as specified by RlSumTree::Find */
+int LinearFind(const vector<RlFloat>& weights, RlFloat target)
+{
+    RlFloat sum = 0;
+    for (int i = 0; i < ssize(weights); ++i)
+    {
+        sum += weights[i];
+        if (sum > target)
+            return i;
+    }
+    return ssize(weights) - 1;
+}
+
+/** Check total and every boundary of the cumulative weights.
+    Weights are whole numbers, so all sums are exact. */
+void CheckTree(const RlSumTree& tree, const vector<RlFloat>& weights)
+{
+    RlFloat total = 0;
+    for (int i = 0; i < ssize(weights); ++i)
+    {
+        BOOST_CHECK_EQUAL(tree.Get(i), weights[i]);
+        total += weights[i];
+    }
+    BOOST_CHECK_EQUAL(tree.Total(), total);
+    for (RlFloat target = 0; target < total; target += 0.5)
+        BOOST_CHECK_EQUAL(tree.Find(target), LinearFind(weights, target));
+}
+
+BOOST_AUTO_TEST_CASE(RlSumTreeTestSet)
+{
+    // Sizes around powers of two, with some zero weights
+    for (int size = 1; size <= 35; ++size)
+    {
+        RlSumTree tree(size);
+        vector<RlFloat> weights(size, 0);
+        BOOST_CHECK_EQUAL(tree.Size(), size);
+        BOOST_CHECK_EQUAL(tree.Total(), 0);
+        for (int i = 0; i < size; ++i)
+        {
+            weights[i] = (i * 7) % 5;
+            tree.Set(i, weights[i]);
+        }
+        CheckTree(tree, weights);
+
+        // Change weights in a different order, including to zero
+        for (int i = size - 1; i >= 0; i -= 2)
+        {
+            weights[i] = (i * 3) % 4;
+            tree.Set(i, weights[i]);
+        }
+        CheckTree(tree, weights);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(RlSumTreeTestFind)
+{
+    // Zero weights are never found, except at the end when the
+    // target is beyond the total
+    RlSumTree tree(8);
+    tree.Set(0, 0);
+    tree.Set(2, 1);
+    tree.Set(5, 2);
+    BOOST_CHECK_EQUAL(tree.Find(0), 2);
+    BOOST_CHECK_EQUAL(tree.Find(0.5), 2);
+    BOOST_CHECK_EQUAL(tree.Find(1), 5);
+    BOOST_CHECK_EQUAL(tree.Find(2.999), 5);
+    BOOST_CHECK_EQUAL(tree.Find(3), 7);
+    BOOST_CHECK_EQUAL(tree.Find(100), 7);
+}
+
+BOOST_AUTO_TEST_CASE(RlSumTreeTestRebuild)
+{
+    // Many small updates accumulate rounding errors in the partial sums,
+    // rebuilding recomputes them from the weights
+    const int size = 21;
+    RlSumTree tree(size);
+    vector<RlFloat> weights(size, 0);
+    for (int n = 0; n < 10000; ++n)
+    {
+        int i = (n * 13) % size;
+        weights[i] = 0.1 * ((n * 7) % 11);
+        tree.Set(i, weights[i]);
+    }
+    for (int i = 0; i < size; ++i)
+    {
+        weights[i] = i % 4;
+        tree.Set(i, weights[i]);
+    }
+    tree.Rebuild();
+    CheckTree(tree, weights);
+
+    // Rebuild doesn't change exact sums
+    tree.Rebuild();
+    CheckTree(tree, weights);
+
+    // Resize clears all weights
+    tree.Resize(size);
+    weights.assign(size, 0);
+    CheckTree(tree, weights);
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
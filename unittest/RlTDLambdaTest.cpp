@@ -1,190 +1,210 @@
-#ifdef RL_ELIGIBILITY
-BOOST_AUTO_TEST_CASE(RlAgentTestTDLambda1)
+//----------------------------------------------------------------------------
+/** @file RlTDLambdaTest.cpp
+    Unit tests for RlTDLambda
+*/
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+
+#include <boost/test/floating_point_comparison.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/test/auto_unit_test.hpp>
+#include "RlTDRules.h"
+
+#include "RlActiveSet.h"
+#include "RlEvaluator.h"
+#include "RlHistory.h"
+#include "RlManualFeatures.h"
+#include "RlMathUtil.h"
+#include "RlMoveFilter.h"
+#include "RlState.h"
+#include "RlWeightSet.h"
+#include "RlTestUtil.h"
+
+using namespace std;
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+// percentage tolerance for floating point comparison
+const float tol = 0.001f;
+
+/** Learn from two steps: features f0 (occurrences o0) and f1 (o1) in the
+    first state, f1 (o1) and f2 (1) in the second state, then a terminal
+    state with the specified score */
+void TDLambdaSteps(RlManualFeatureSet& f, RlEvaluator& ev, RlTDLambda& td,
+    RlHistory& history, int o0, int o1, RlFloat score)
 {
-    GoBoard bd(9);
-    RlActiveConnections active(4);
-    RlConnector connector(bd);
-    RlManualFeatureSet f(bd, 4);
-    RlManualTracker tracker(bd, &f, &connector);
-    RlConnectionSet* w = connector.AddSet(&f);
-    RlEvaluator ev(bd);
-    ev.AddTracker(&tracker);
-    RlSimpleStepSize stepsize(bd, 1.0);
-    RlTDLambda td(bd, &ev, &stepsize, 0, 0, 0.5f);
-    connector.EnsureInitialised();
-    ev.EnsureInitialised();
-    td.EnsureInitialised();
-
-    w.ZeroWeights();
-    w.Get(3).Weight() += 1.0;
+    RlState s1(1, SG_BLACK);
+    RlState s2(2, SG_WHITE);
+    RlState s3(3, SG_BLACK);
+    history.NewEpisode();
+    td.Start(&history, 0);
 
     f.Clear();
-    f.Set(0, 1);
-    f.Set(1, 1);
+    f.Set(0, o0);
+    f.Set(1, o1);
     ev.Reset();
-    ev.Evaluate();
-    ev.GetActive(active);
-    float value1 = ev.Eval();
-    td.SetData(&active, value1, value1, 0.0, false);
-    td.Learn();
-    
-    active.Clear();
+    s1.SetActive(ev.Active());
+    s1.SetEval(ev.Eval());
+
     f.Clear();
-    f.Set(1, 1);
+    f.Set(1, o1);
     f.Set(2, 1);
     ev.Reset();
-    ev.Evaluate();
-    ev.GetActive(active);
-    float value2 = ev.Eval();
-    td.SetData(&active, value2, value2, 1.0, false);
+    s2.SetActive(ev.Active());
+    s2.SetEval(ev.Eval());
+    s3.SetTerminal(score);
+
+    // No error in first step, so only eligibility traces change
+    td.SetData(s1, s2);
+    td.Learn();
+    td.SetData(s2, s3);
     td.Learn();
+}
 
-    BOOST_CHECK_CLOSE(
-        w.Get(0)->Eligibility(), 0.5f, tol);
-    BOOST_CHECK_CLOSE(
-        w.Get(1)->Eligibility(), 1.5f, tol);
-    BOOST_CHECK_CLOSE(
-        w.Get(2)->Eligibility(), 1.0, tol);
+struct TDLambdaFixture
+{
+    TDLambdaFixture()
+    :   bd(9),
+        f(bd, 4),
+        tracker(bd, &f),
+        w(bd, &f),
+        mf(bd),
+        ev(bd, &f, &w, &mf),
+        td(bd, &w, 0, 0.5),
+        history(bd)
+    {
+        f.EnsureInitialised();
+        w.EnsureInitialised();
+        ev.EnsureInitialised();
+        td.EnsureInitialised();
+        history.EnsureInitialised();
+        history.Allocate();
+    }
+
+    GoBoard bd;
+    RlManualFeatureSet f;
+    RlManualTracker tracker;
+    RlWeightSet w;
+    RlMoveFilter mf;
+    RlEvaluator ev;
+    RlTDLambda td;
+    RlHistory history;
+};
+
+BOOST_FIXTURE_TEST_CASE(RlAgentTestTDLambda1, TDLambdaFixture)
+{
+    w.ZeroWeights();
+    w.Get(3).Weight() += 1.0;
+    TDLambdaSteps(f, ev, td, history, 1, 1, 1.0);
+
+    BOOST_CHECK_CLOSE(td.GetEligibility(0), 0.5, tol);
+    BOOST_CHECK_CLOSE(td.GetEligibility(1), 1.5, tol);
+    BOOST_CHECK_CLOSE(td.GetEligibility(2), 1.0, tol);
 
     BOOST_CHECK(w.Get(0).Weight() > 0);
     BOOST_CHECK(w.Get(1).Weight() > 0);
     BOOST_CHECK(w.Get(2).Weight() > 0);
     BOOST_CHECK(w.Get(3).Weight() == 1.0);
 
-    BOOST_CHECK_CLOSE(
-        w.Get(1).Weight(),
-        w.Get(0).Weight() * 3.0, tol);
-    BOOST_CHECK_CLOSE(
-        w.Get(1).Weight(),
-        w.Get(2).Weight() * 1.5f, tol);
-    BOOST_CHECK_CLOSE(
-        w.Get(2).Weight(),
-        w.Get(0).Weight() * 2.0, tol);
+    BOOST_CHECK_CLOSE(w.Get(1).Weight(), w.Get(0).Weight() * 3.0, tol);
+    BOOST_CHECK_CLOSE(w.Get(1).Weight(), w.Get(2).Weight() * 1.5, tol);
+    BOOST_CHECK_CLOSE(w.Get(2).Weight(), w.Get(0).Weight() * 2.0, tol);
 }
 
-BOOST_AUTO_TEST_CASE(RlAgentTestTDLambda2)
+BOOST_FIXTURE_TEST_CASE(RlAgentTestTDLambda2, TDLambdaFixture)
 {
-    GoBoard bd(9);
-    RlActiveConnections active(4);
-    RlConnector connector(bd);
-    RlManualFeatureSet f(bd, 4);
-    RlManualTracker tracker(bd, &f, &connector);
-    RlConnectionSet* w = connector.AddSet(&f);
-    RlEvaluator ev(bd);
-    ev.AddTracker(&tracker);
-    RlSimpleStepSize stepsize(bd, 1.0);
-    RlTDLambda td(bd, &ev, &stepsize, 0, 0, 0.5f);
-    connector.EnsureInitialised();
-    ev.EnsureInitialised();
-    td.EnsureInitialised();
-
     w.ZeroWeights();
     w.Get(3).Weight() += -1.0;
+    TDLambdaSteps(f, ev, td, history, 1, 1, -1.0);
 
-    f.Clear();
-    f.Set(0, 1);
-    f.Set(1, 1);
-    ev.Reset();
-    ev.Evaluate();
-    ev.GetActive(active);
-    float value1 = ev.Eval();
-    td.SetData(&active, value1, value1, 0.0, false);
-    td.Learn();
-
-    active.Clear();
-    f.Clear();
-    f.Set(1, 1);
-    f.Set(2, 1);
-    ev.Reset();
-    ev.Evaluate();
-    ev.GetActive(active);
-    float value2 = ev.Eval();
-    td.SetData(&active, value2, value2, -1.0, false);
-    td.Learn();
-
-    BOOST_CHECK_CLOSE(
-        w.Get(0)->Eligibility(), 0.5f, tol);
-    BOOST_CHECK_CLOSE(
-        w.Get(1)->Eligibility(), 1.5f, tol);
-    BOOST_CHECK_CLOSE(
-        w.Get(2)->Eligibility(), 1.0, tol);
+    BOOST_CHECK_CLOSE(td.GetEligibility(0), 0.5, tol);
+    BOOST_CHECK_CLOSE(td.GetEligibility(1), 1.5, tol);
+    BOOST_CHECK_CLOSE(td.GetEligibility(2), 1.0, tol);
 
     BOOST_CHECK(w.Get(0).Weight() < 0);
     BOOST_CHECK(w.Get(1).Weight() < 0);
     BOOST_CHECK(w.Get(2).Weight() < 0);
     BOOST_CHECK(w.Get(3).Weight() == -1.0);
 
-    BOOST_CHECK_CLOSE(
-        w.Get(1).Weight(),
-        w.Get(0).Weight() * 3.0, tol);
-    BOOST_CHECK_CLOSE(
-        w.Get(1).Weight(),
-        w.Get(2).Weight() * 1.5f, tol);
-    BOOST_CHECK_CLOSE(
-        w.Get(2).Weight(),
-        w.Get(0).Weight() * 2.0, tol);
+    BOOST_CHECK_CLOSE(w.Get(1).Weight(), w.Get(0).Weight() * 3.0, tol);
+    BOOST_CHECK_CLOSE(w.Get(1).Weight(), w.Get(2).Weight() * 1.5, tol);
+    BOOST_CHECK_CLOSE(w.Get(2).Weight(), w.Get(0).Weight() * 2.0, tol);
 }
 
-BOOST_AUTO_TEST_CASE(RlAgentTestTDLambda3)
+BOOST_FIXTURE_TEST_CASE(RlAgentTestTDLambda3, TDLambdaFixture)
 {
-    GoBoard bd(9);
-    RlActiveConnections active(4);
-    RlConnector connector(bd);
-    RlManualFeatureSet f(bd, 4);
-    RlManualTracker tracker(bd, &f, &connector);
-    RlConnectionSet* w = connector.AddSet(&f);
-    RlEvaluator ev(bd);
-    ev.AddTracker(&tracker);
-    RlSimpleStepSize stepsize(bd, 1.0);
-    RlTDLambda td(bd, &ev, &stepsize, 0, 0, 0.5f);
-    connector.EnsureInitialised();
-    ev.EnsureInitialised();
-    td.EnsureInitialised();
-
     w.ZeroWeights();
     w.Get(3).Weight() += 1.0;
+    TDLambdaSteps(f, ev, td, history, 3, 2, 1.0);
 
-    f.Clear();
-    f.Set(0, 3);
-    f.Set(1, 2);
-    ev.Reset();
-    ev.Evaluate();
-    ev.GetActive(active);
-    float value1 = ev.Eval();
-    td.SetData(&active, value1, value1, 0.0, false);
-    td.Learn();
-    
-    active.Clear();
-    f.Clear();
-    f.Set(1, 2);
-    f.Set(2, 1);
-    ev.Reset();
-    ev.Evaluate();
-    ev.GetActive(active);
-    float value2 = ev.Eval();
-    td.SetData(&active, value2, value2, 1.0, false);
-    td.Learn();
-
-    BOOST_CHECK_CLOSE(
-        w.Get(0)->Eligibility(), 1.5f, tol);
-    BOOST_CHECK_CLOSE(
-        w.Get(1)->Eligibility(), 3.0, tol);
-    BOOST_CHECK_CLOSE(
-        w.Get(2)->Eligibility(), 1.0, tol);
+    BOOST_CHECK_CLOSE(td.GetEligibility(0), 1.5, tol);
+    BOOST_CHECK_CLOSE(td.GetEligibility(1), 3.0, tol);
+    BOOST_CHECK_CLOSE(td.GetEligibility(2), 1.0, tol);
 
     BOOST_CHECK(w.Get(0).Weight() > 0);
     BOOST_CHECK(w.Get(1).Weight() > 0);
     BOOST_CHECK(w.Get(2).Weight() > 0);
     BOOST_CHECK(w.Get(3).Weight() == 1.0);
 
-    BOOST_CHECK_CLOSE(
-        w.Get(1).Weight(),
-        w.Get(0).Weight() * 2.0, tol);
-    BOOST_CHECK_CLOSE(
-        w.Get(1).Weight(),
-        w.Get(2).Weight() * 3.0, tol);
-    BOOST_CHECK_CLOSE(
-        w.Get(0).Weight(),
-        w.Get(2).Weight() * 1.5f, tol);
+    BOOST_CHECK_CLOSE(w.Get(1).Weight(), w.Get(0).Weight() * 2.0, tol);
+    BOOST_CHECK_CLOSE(w.Get(1).Weight(), w.Get(2).Weight() * 3.0, tol);
+    BOOST_CHECK_CLOSE(w.Get(0).Weight(), w.Get(2).Weight() * 1.5, tol);
+}
+
+BOOST_AUTO_TEST_CASE(RlAgentTestTDLambdaRenormalise)
+{
+    // With a small lambda, the global trace scale falls below its minimum
+    // every few steps. Traces of features that stay active must still
+    // match the directly computed traces, e(t) = lambda * e(t-1) + occur,
+    // and so must the weight updates.
+    GoBoard bd(9);
+    RlManualFeatureSet f(bd, 4);
+    RlWeightSet w(bd, &f);
+    const RlFloat lambda = 0.01;
+    RlTDLambda td(bd, &w, 0, lambda);
+    RlHistory history(bd);
+    f.EnsureInitialised();
+    w.EnsureInitialised();
+    td.EnsureInitialised();
+    history.EnsureInitialised();
+    history.Allocate();
+    history.NewEpisode();
+    w.ZeroWeights();
+    td.Start(&history, 0);
+
+    // Features 0 and 1 are active in every state, with 1 and 2 occurrences
+    RlActiveSet active(2);
+    active.Change(RlChange(0, 0, +1));
+    active.Change(RlChange(1, 1, +2));
+    RlState s1(1, SG_BLACK);
+    RlState s2(2, SG_WHITE);
+    s1.SetActive(active);
+    s1.SetEval(0.0);
+    s2.SetEval(1.0);
+
+    // Default step-size is normalised by the sum of squared occurrences
+    RlFloat delta = RlMathUtil::Logistic(1.0) - RlMathUtil::Logistic(0.0);
+    RlFloat step = 0.1 / (1 * 1 + 2 * 2);
+    RlFloat e0 = 0, e1 = 0, w0 = 0, w1 = 0;
+    for (int t = 0; t < 40; ++t)
+    {
+        e0 = lambda * e0 + 1;
+        e1 = lambda * e1 + 2;
+        w0 += step * delta * e0;
+        w1 += step * delta * e1;
+        td.SetData(s1, s2);
+        td.Learn();
+        BOOST_CHECK_CLOSE(td.GetEligibility(0), e0, tol);
+        BOOST_CHECK_CLOSE(td.GetEligibility(1), e1, tol);
+        BOOST_CHECK_CLOSE(w.Get(0).Weight(), w0, tol);
+        BOOST_CHECK_CLOSE(w.Get(1).Weight(), w1, tol);
+    }
+    BOOST_CHECK_EQUAL(td.GetEligibility(2), 0);
 }
-#endif // RL_ELIGIBILITY
+
+} // namespace
+
+//----------------------------------------------------------------------------
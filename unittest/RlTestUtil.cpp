@@ -8,7 +8,14 @@
 #include "RlTestUtil.h"
 
 #include "RlBinaryFeatures.h"
+#include "RlEvaluator.h"
+#include "RlMoveFilter.h"
 #include "RlTracker.h"
+#include "RlWeightSet.h"
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
 
 using namespace std;
 
@@ -109,4 +116,93 @@ void DisplayActive(const RlActiveSet& active, RlBinaryFeatures& features)
     }
 }
 
+void SetTestWeights(RlWeightSet& weights, RlFloat maxweight)
+{
+    // Same weights in every run, so that failures are reproducible
+    unsigned int seed = 12345;
+    for (int i = 0; i < weights.GetNumFeatures(); ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        int r = (int) ((seed >> 8) % 2001) - 1000;
+        weights.Get(i).Weight() = r * maxweight / 1000;
+    }
+    weights.WeightsChanged();
+}
+
+RlTestObjects::RlTestObjects(int size, const string& settings)
+:   m_board(new GoBoard(size))
+{
+    RlGetFactory().AddBoard(m_board);
+    istringstream stream(settings);
+    RlGetFactory().Load(*m_board, stream);
+}
+
+RlTestObjects::~RlTestObjects()
+{
+    RlGetFactory().Clear();
+}
+
+string EvaluatorSettings(const string& prefix, bool differences,
+    int deltacache, const string& filter)
+{
+    ostringstream settings;
+    settings
+        << "Object = RlLocalShapeFeatures\n{\n"
+        << "    ID = " << prefix << "Shapes\n    Version = 1\n"
+        << "    XSize = 2\n    YSize = 2\n}\n\n"
+        << "Object = RlWeightSet\n{\n"
+        << "    ID = " << prefix << "Weights\n"
+        << "    FeatureSet = " << prefix << "Shapes\n"
+        << "    ShareName = NULL\n    Strict = 1\n"
+        << "    StreamMode = 0\n    SinglePrecision = 0\n}\n\n"
+        << "Object = " << filter << "\n{\n"
+        << "    ID = " << prefix << "Filter\n    ConsiderPass = 1\n}\n\n"
+        << "Object = RlEvaluator\n{\n"
+        << "    ID = " << prefix << "Evaluator\n    Version = 8\n"
+        << "    FeatureSet = " << prefix << "Shapes\n"
+        << "    WeightSet = " << prefix << "Weights\n"
+        << "    MoveFilter = " << prefix << "Filter\n"
+        << "    Differences = " << differences << "\n"
+        << "    SupportUndo = 1\n"
+        << "    DeltaCache = " << deltacache << "\n"
+        << "    RebuildInterval = 0\n}\n\n";
+    return settings.str();
+}
+
+void PlayRandomGame(RlEvaluator& evaluator, unsigned int seed, int numsteps,
+    int undopercent, RlRandomGameHooks& hooks)
+{
+    GoBoard& bd = evaluator.GetBoard();
+    const RlMoveFilter* filter = evaluator.GetMoveFilter();
+    int numplayed = 0;
+    for (int step = 0; step < numsteps; ++step)
+    {
+        hooks.Position();
+        seed = seed * 1103515245u + 12345u;
+        if (numplayed > 0 && (int) ((seed >> 8) % 100) < undopercent)
+        {
+            evaluator.TakeBackUndo(false);
+            numplayed--;
+            hooks.AfterUndo();
+            continue;
+        }
+
+        vector<SgMove> moves;
+        filter->GetMoveVector(bd.ToPlay(), moves);
+        moves.erase(remove(moves.begin(), moves.end(), SG_PASS), 
+            moves.end());
+        if (moves.empty())
+            break;
+        hooks.BeforePlay();
+        evaluator.PlayExecute(moves[(seed >> 12) % moves.size()], 
+            bd.ToPlay(), false);
+        numplayed++;
+    }
+    while (numplayed-- > 0)
+    {
+        evaluator.TakeBackUndo(false);
+        hooks.AfterUndo();
+    }
+}
+
 //----------------------------------------------------------------------------
@@ -8,11 +8,16 @@
 #define RLTESTUTIL_H
 
 #include "GoBoard.h"
+#include "RlFactory.h"
+#include "RlMiscUtil.h"
+#include "SgException.h"
 #include "SgRect.h"
 
 class RlTracker;
 class RlBinaryFeatures;
 class RlActiveSet;
+class RlEvaluator;
+class RlWeightSet;
 
 //----------------------------------------------------------------------------
 
@@ -36,6 +41,71 @@ int CountOccurrences(const RlActiveSet& active, int featureindex);
 SgRect MakeRect(int x, int y);
 void DisplayActive(const RlActiveSet& active, RlBinaryFeatures& features);
 
+/** Objects loaded from settings text into the factory, on a new board
+    owned by the factory. Objects must be loaded from settings when they are
+    cloned by the factory, or to change settings without a setter.
+    The factory is cleared when the test objects go out of scope, so that
+    tests don't share objects. */
+class RlTestObjects
+{
+public:
+
+    RlTestObjects(int size, const std::string& settings);
+    ~RlTestObjects();
+
+    GoBoard& Board() { return *m_board; }
+
+    /** Get an initialised object of the specified type */
+    template <class T> T* Get(const std::string& id) const;
+
+private:
+
+    GoBoard* m_board;
+};
+
+template <class T> T* RlTestObjects::Get(const std::string& id) const
+{
+    T* object = dynamic_cast<T*>(RlGetFactory().GetObject(id));
+    if (!object)
+        throw SgException("Wrong type for test object: " + id);
+    object->EnsureInitialised();
+    return object;
+}
+
+/** Settings for an evaluator of 2x2 local shapes with undo support.
+    Defines objects with IDs prefix + "Shapes", "Weights", "Filter" and
+    "Evaluator". The filter is of the specified class and considers pass. */
+std::string EvaluatorSettings(const std::string& prefix, bool differences,
+    int deltacache, const std::string& filter = "RlMoveFilter");
+
+/** Set deterministic pseudo-random weights in [-maxweight, +maxweight] */
+void SetTestWeights(RlWeightSet& weights, RlFloat maxweight);
+
+/** Hooks called by PlayRandomGame */
+class RlRandomGameHooks
+{
+public:
+
+    virtual ~RlRandomGameHooks() { }
+
+    /** Called in every position, before the next step */
+    virtual void Position() { }
+
+    /** Called before a move is played */
+    virtual void BeforePlay() { }
+
+    /** Called after a move is taken back */
+    virtual void AfterUndo() { }
+};
+
+/** Play a reproducible random game through the evaluator, with simulated
+    moves. At each step the last move is taken back with the specified
+    percentage probability, otherwise a random non-pass move allowed by
+    the evaluator's move filter is played. The game stops early if only 
+    pass is allowed. All moves are taken back at the end. */
+void PlayRandomGame(RlEvaluator& evaluator, unsigned int seed, int numsteps,
+    int undopercent, RlRandomGameHooks& hooks);
+
 //----------------------------------------------------------------------------
 
 #endif // RLTESTUTIL_H
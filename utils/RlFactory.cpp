@@ -6,6 +6,7 @@
 #include "SgSystem.h"
 #include "RlFactory.h"
 
+#include "GoBoard.h"
 #include "SgDebug.h"
 #include "SgException.h"
 #include "RlUtils.h"
@@ -65,7 +66,8 @@ RlRegister::RlRegister(const string& name, RlFactoryFn factoryfn)
 //----------------------------------------------------------------------------
 
 RlFactory::RlFactory()
-:   m_enabled(true)
+:   m_enabled(true),
+    m_cloneBoard(0)
 {
 }
 
@@ -85,6 +87,14 @@ void RlFactory::Clear()
     m_objects.clear();
     m_objectVector.clear();
     m_IDs.clear();
+    m_settings.clear();
+
+    for (vector<GoBoard*>::iterator i_board = m_boards.begin();
+        i_board != m_boards.end(); ++i_board)
+    {
+        delete *i_board;
+    }
+    m_boards.clear();
 }
 
 void RlFactory::Register(const string& name, RlFactoryFn factoryfn)
@@ -95,6 +105,10 @@ void RlFactory::Register(const string& name, RlFactoryFn factoryfn)
 
 RlAutoObject* RlFactory::GetObject(const string& id)
 {
+    // During cloning, references are redirected to the copies
+    if (m_cloneBoard)
+        return CloneObject(id);
+
     if (m_objects.find(id) == m_objects.end())
     {
         ostringstream ss;
@@ -188,6 +202,15 @@ void RlFactory::Load(GoBoard& board, const bfs::path& filename)
     LoadAllObjects(board, filename);
 }
 
+void RlFactory::Load(GoBoard& board, istream& settings)
+{
+    istream::pos_type start = settings.tellg();
+    AllocateObjects(board, settings);
+    settings.clear();
+    settings.seekg(start);
+    LoadObjects(settings);
+}
+
 bfs::path RlFactory::GetFullPath(const bfs::path& filename)
 {
     bfs::path fullpath;
@@ -265,14 +288,113 @@ void RlFactory::LoadObjects(istream& settings)
         settings >> RlSkipTo("{") >> ws;
         settings >> RlSetting<string>("ID", m_currentID);
         RlAutoObject* object = GetObject(m_currentID);
+        istream::pos_type start = settings.tellg();
         object->LoadSettings(settings);
         RlInclude* include = dynamic_cast<RlInclude*>(object);
         if (include)
             include->Load(settings);
-        settings >> RlSkipToBracket('{', '}', 1) >> ws;
+        settings >> RlSkipToBracket('{', '}', 1);
+
+        // Remember settings so that object can be cloned later
+        istream::pos_type end = settings.tellg();
+        if (start != istream::pos_type(-1) && end != istream::pos_type(-1))
+        {
+            string text(end - start, ' ');
+            settings.seekg(start);
+            settings.read(&text[0], text.size());
+            m_settings[object] = text;
+        }
+        settings >> ws;
     }
 }
 
+RlAutoObject* RlFactory::Clone(const string& id, GoBoard& board,
+    const string& suffix, const set<string>& shared)
+{
+    if (m_cloneBoard)
+        throw SgException("Clone already in progress");
+
+    m_cloneBoard = &board;
+    m_cloneSuffix = suffix;
+    m_cloneShared = shared;
+    m_clones.clear();
+    m_newClones.clear();
+    string currentID = m_currentID;
+    RlAutoObject* clone = 0;
+    try
+    {
+        clone = CloneObject(id);
+    }
+    catch (...)
+    {
+        m_cloneBoard = 0;
+        m_currentID = currentID;
+        throw;
+    }
+    m_cloneBoard = 0;
+    m_currentID = currentID;
+    
+    // Initialise copies once the whole graph has been loaded
+    for (vector<RlAutoObject*>::iterator i_clone = m_newClones.begin();
+        i_clone != m_newClones.end(); ++i_clone)
+    {
+        (*i_clone)->EnsureInitialised();
+    }
+    m_newClones.clear();
+    m_clones.clear();
+    return clone;
+}
+
+RlAutoObject* RlFactory::CloneObject(const string& id)
+{
+    map<string, RlAutoObject*>::iterator i_clone = m_clones.find(id);
+    if (i_clone != m_clones.end())
+        return i_clone->second;
+
+    map<string, RlAutoObject*>::iterator i_object = m_objects.find(id);
+    if (i_object == m_objects.end())
+    {
+        ostringstream ss;
+        ss << "No object in factory with id: " << id;
+        throw SgException(ss.str());
+    }
+    RlAutoObject* original = i_object->second;
+    if (original->IsShared() || m_cloneShared.count(id))
+    {
+        m_clones[id] = original;
+        return original;
+    }
+
+    map<RlAutoObject*, string>::iterator i_settings 
+        = m_settings.find(original);
+    if (i_settings == m_settings.end())
+    {
+        ostringstream ss;
+        ss << "No settings available to clone object: " << id;
+        throw SgException(ss.str());
+    }
+
+    // Register copy before loading, so that cyclic references resolve
+    RlAutoObject* clone = CreateObject(*m_cloneBoard, original->GetName());
+    AddObject(clone, id + m_cloneSuffix);
+    m_clones[id] = clone;
+    m_newClones.push_back(clone);
+    m_settings[clone] = i_settings->second;
+
+    // Overrides for the original object also apply to the copy
+    string currentID = m_currentID;
+    m_currentID = id;
+    istringstream settings(i_settings->second);
+    clone->LoadSettings(settings);
+    m_currentID = currentID;
+    return clone;
+}
+
+void RlFactory::AddBoard(GoBoard* board)
+{
+    m_boards.push_back(board);
+}
+
 void RlFactory::Initialise()
 {
     SgDebug() << "Initialising objects from settings file...\n";
@@ -11,6 +11,7 @@
 #include <boost/filesystem/path.hpp>
 #include <iostream>
 #include <map>
+#include <set>
 #include <vector>
 
 namespace bfs = boost::filesystem;
@@ -35,6 +36,14 @@ public:
 
     virtual void LoadSettings(std::istream& settings);
     virtual void SaveSettings(std::ostream& settings);
+
+    /** Whether this object is not modified after initialisation */
+    virtual bool IsReadOnly() const { return false; }
+
+    /** Whether this object is shared by reference between cloned graphs
+        (see RlFactory::Clone), all other objects are copied.
+        By default, read-only objects are shared. */
+    virtual bool IsShared() const { return IsReadOnly(); }
     
     GoBoard& GetBoard() { return m_board; }
     bool IsInitialised() const { return m_initialised; }
@@ -86,6 +95,10 @@ public:
     /** Load objects from settings file into factory */
     void Load(GoBoard& board, const bfs::path& filename);
 
+    /** Load objects from settings stream into factory.
+        The stream is read twice, so must support seeking. */
+    void Load(GoBoard& board, std::istream& settings);
+
     /** Save objects from factory into settings file */
     void Save(const bfs::path& filename);
 
@@ -99,6 +112,22 @@ public:
     /** Delete all objects */
     void Clear();
 
+    /** Clone the graph of objects reachable from the specified object.
+        Copies are bound to the specified board, which must be the same size
+        as the original board. Shared objects (see RlAutoObject::IsShared)
+        and objects listed in shared are shared by reference; all other 
+        objects are copied by reloading their settings, with references 
+        redirected to the copies. 
+        Copies are added to the factory with the original ID plus suffix, 
+        and are initialised before returning. */
+    RlAutoObject* Clone(const std::string& id, GoBoard& board,
+        const std::string& suffix,
+        const std::set<std::string>& shared = std::set<std::string>());
+
+    /** Take ownership of a board used by cloned objects.
+        Boards are deleted after all objects have been deleted. */
+    void AddBoard(GoBoard* board);
+
     void EnableOverrides(bool enabled) { m_enabled = enabled; }
 
     /** Set setting override. 
@@ -128,6 +157,7 @@ protected:
     void AllocateObjects(GoBoard& board, std::istream& settings);
     void LoadObjects(std::istream& settings);
     bool NextObject(std::istream& settings);
+    RlAutoObject* CloneObject(const std::string& id);
     void SetOneOverride(const std::string& token, const std::string& value);
     bool OneOverrideExists(const std::string& token, std::string& override);
 
@@ -138,12 +168,21 @@ private:
     std::map<std::string, RlAutoObject*> m_objects;
     std::vector<RlAutoObject*> m_objectVector;
     std::map<RlAutoObject*, std::string> m_IDs;
+    std::map<RlAutoObject*, std::string> m_settings;
+    std::vector<GoBoard*> m_boards;
     std::string m_currentID;
     std::map<std::string, std::string> m_globalOverrides;
     std::map<std::string, std::map<std::string, std::string> >
         m_localOverrides;
     bool m_enabled;
 
+    /** State of clone in progress (board is null if not cloning) */
+    GoBoard* m_cloneBoard;
+    std::string m_cloneSuffix;
+    std::set<std::string> m_cloneShared;
+    std::map<std::string, RlAutoObject*> m_clones;
+    std::vector<RlAutoObject*> m_newClones;
+
 friend class RlInclude;
 };
 
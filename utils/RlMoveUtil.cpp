@@ -8,6 +8,7 @@
 #include "RlMoveUtil.h"
 
 #include "GoBoard.h"
+#include "RlRandomUtil.h"
 #include "SgBWArray.h"
 #include "SgWrite.h"
 #include <math.h>
@@ -62,6 +63,17 @@ RlStone GetHistory(const GoBoard& board, int movenum)
     return stone;
 }
 
+void CopyBoard(const GoBoard& source, GoBoard& board)
+{
+    board.Init(source.Size(), source.Rules(), source.Setup());
+    for (int i = 0; i < source.MoveNumber(); ++i)
+    {
+        GoPlayerMove move = source.Move(i);
+        board.Play(move.Point(), move.Color());
+    }
+    board.SetToPlay(source.ToPlay());
+}
+
 bool QuickResign(const GoBoard& board, SgBlackWhite toplay)
 {
     SgBWArray<int> numstones;
@@ -83,7 +95,7 @@ int SelectRandom(const vector<RlFloat>& probs)
 {
     // Select a random index from discrete probability distribution
     int size = probs.size();
-    RlFloat r = SgRandomFloat(0, 1);
+    RlFloat r = RlRandomUtil::Float(0, 1);
     for (int i = 0; i < size; ++i)
     {
         r -= probs[i];
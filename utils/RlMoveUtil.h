@@ -126,6 +126,9 @@ namespace RlMoveUtil
 /** Get a stone from the board history */
 RlStone GetHistory(const GoBoard& board, int movenum);
 
+/** Set up board to match source board, including rules and move history */
+void CopyBoard(const GoBoard& source, GoBoard& board);
+
 /** Mercy rule for quick resignation */
 bool QuickResign(const GoBoard& board, SgBlackWhite toplay);
 
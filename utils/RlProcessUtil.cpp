@@ -8,147 +8,424 @@
 #include "RlProcessUtil.h"
 
 #include "SgException.h"
-
-// Define this for multi-processing capability
-#define RL_MULTI
-
-#ifdef RL_MULTI
-#include <sys/types.h>
-#include <sys/ipc.h> 
-#include <sys/shm.h> 
-#include <sys/sem.h> 
-#include <sys/errno.h>
-#endif // RL_MULTI
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 
 using namespace std;
 
 //----------------------------------------------------------------------------
 
-#ifdef RL_MULTI
+namespace {
+
+const int SHARED_MAGIC = 0x52534d48; // "RSMH"
 
-RlSharedMemory::RlSharedMemory(
-    const bfs::path& sharename, int index, int bytes)
+} // namespace
+
+RlSharedMemory::RlSharedMemory(const bfs::path& filename, int bytes)
+:   m_filename(filename),
+    m_fd(-1),
+    m_size(sizeof(Header) + bytes),
+    m_base(0),
+    m_data(0),
+    m_creator(false)
 {
-    std::string filename = sharename.native_file_string();
-    key_t key = ftok(filename.c_str(), index);
-    if (key == -1)
-        throw SgException("Shared file " + filename + " doesn't exist");
-    m_id = shmget(key, bytes, 0644 | IPC_CREAT);
-    if (m_id == -1)
-        Error("shmget");
-    m_data = (char*) shmat(m_id, 0, 0);
-    if (m_data == (char*) -1)
-        Error("shmat");
+    std::string name = filename.native_file_string();
+    struct stat info;
+    while (true)
+    {
+        m_fd = open(name.c_str(), O_RDWR | O_CREAT, 0644);
+        if (m_fd == -1)
+            Error("open");
+        if (flock(m_fd, LOCK_EX) == -1)
+            Error("flock");
+        if (fstat(m_fd, &info) == -1)
+            Error("fstat");
+
+        // Retry if last process detached (and removed file) while waiting
+        if (info.st_nlink > 0)
+            break;
+        close(m_fd);
+    }
+    
+    m_creator = (info.st_size == 0);
+    if (m_creator && ftruncate(m_fd, m_size) == -1)
+        Error("ftruncate");
+    if (!m_creator && info.st_size != (off_t) m_size)
+    {
+        close(m_fd);
+        throw SgException("Shared memory " + name + " has wrong size");
+    }
+    
+    void* base = mmap(0, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (base == MAP_FAILED)
+        Error("mmap");
+    m_base = static_cast<char*>(base);
+    m_data = m_base + sizeof(Header);
+
+    Header* header = reinterpret_cast<Header*>(m_base);
+    if (m_creator)
+    {
+        header->m_magic = SHARED_MAGIC;
+        header->m_bytes = bytes;
+        header->m_attached = 0;
+    }
+    else if (header->m_magic != SHARED_MAGIC || header->m_bytes != bytes)
+    {
+        munmap(m_base, m_size);
+        close(m_fd);
+        throw SgException("Shared memory " + name + " has wrong format");
+    }
+    header->m_attached++;
+    flock(m_fd, LOCK_UN);
 }
 
 RlSharedMemory::~RlSharedMemory()
 {
-    if (shmdt(m_data) == -1)
-        throw SgException("Failed to detach shared memory");
+    flock(m_fd, LOCK_EX);
+    Header* header = reinterpret_cast<Header*>(m_base);
+    if (--header->m_attached == 0)
+        unlink(m_filename.native_file_string().c_str());
+    munmap(m_base, m_size);
+    flock(m_fd, LOCK_UN);
+    close(m_fd);
+}
 
-    // Will only delete shared memory once everyone is detached.
-    shmctl(m_id, IPC_RMID, 0);
+int RlSharedMemory::GetNumAttached() const
+{
+    return reinterpret_cast<const Header*>(m_base)->m_attached;
 }
 
 void RlSharedMemory::Error(const string& funcname)
 {
-    // Note: must ensure that system allows large shared memory segments
-    // On Mac OS X, specify in /etc/rc: sysctl -w kern.sysv.shmmax=blah
-    switch(errno)
-    {
-    case EACCES:
-        throw SgException("Don't have permission for existing shared memory ["
-            + funcname + "]");
-    case ENOSPC:
-        throw SgException("Too many shared memory identifiers ["
-            + funcname + "]");
-    case ENOMEM:
-        throw SgException("Not enough memory for shared memory object ["
-            + funcname + "]");
-    case EINVAL:
-        throw SgException("Invalid shared memory arg (size exceeds shmmax?) ["
-            + funcname + "]");
-    case EEXIST:
-    case ENOENT:
-        throw SgException("This error should not occur ["
-            + funcname + "]");
-    default:
-        throw SgException("Failed to share memory: unknown error ["
-            + funcname + "]");
-    }
+    int error = errno;
+    if (m_fd != -1)
+        close(m_fd);
+    ostringstream ss;
+    ss << "Failed to share memory " << m_filename.native_file_string()
+        << ": " << strerror(error) << " [" << funcname << "]";
+    throw SgException(ss.str());
 }
 
-RlSemaphore::RlSemaphore(const bfs::path& semname, int index)
+RlSemaphore::RlSemaphore(const bfs::path& lockname)
 {
-    std::string filename = semname.native_file_string();
-    key_t key = ftok(filename.c_str(), index);
-    if (key == -1)
-        throw SgException("Semaphore " + filename + " doesn't exist");
-    m_id = semget(key, 1, 0644 | IPC_CREAT);
-    if (semctl(m_id, 0, SETVAL, 1) == -1)
-        throw SgException("Failed to initialise semaphore");
+    std::string filename = lockname.native_file_string();
+    m_fd = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_fd == -1)
+        throw SgException("Failed to open lock file " + filename);
 }
 
 RlSemaphore::~RlSemaphore()
 {
-    semctl(m_id, 0, IPC_RMID);
+    close(m_fd);
 }
 
 void RlSemaphore::Lock()
 {
-    struct sembuf op;
-    op.sem_num = 0;
-    op.sem_op = -1;
-    op.sem_flg = 0;
-    semop(m_id, &op, 1);
+    flock(m_fd, LOCK_EX);
 }
 
 void RlSemaphore::Unlock()
 {
-    struct sembuf op;
-    op.sem_num = 0;
-    op.sem_op = 1;
-    op.sem_flg = 0;
-    semop(m_id, &op, 1);
+    flock(m_fd, LOCK_UN);
+}
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+void MakeAddress(const bfs::path& name, sockaddr_un& address)
+{
+    std::string filename = name.native_file_string();
+    if (filename.size() >= sizeof(address.sun_path))
+        throw SgException("Socket name too long: " + filename);
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, filename.c_str());
 }
 
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
 #else
+const int SEND_FLAGS = 0;
+#endif
 
-RlSharedMemory::RlSharedMemory(
-    const std::string& sharename, int index, int bytes)
-:   m_id(0),
-    m_data(0)
+/** Suppress SIGPIPE per socket where send() has no MSG_NOSIGNAL */
+void NoSigPipe(int fd)
 {
-    SG_UNUSED(sharename);
-    SG_UNUSED(index);
-    SG_UNUSED(bytes);
-    throw SgException("Tried to share memory without RL_MULTI defined");
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+    SG_UNUSED(fd);
+#endif
 }
 
-RlSharedMemory::~RlSharedMemory()
+} // namespace
+
+RlSocket::RlSocket(int fd)
+:   m_fd(fd)
 {
-    throw SgException("Tried to share memory without RL_MULTI defined");
+    if (m_fd != -1)
+        NoSigPipe(m_fd);
 }
 
-RlSemaphore::RlSemaphore(const std::string& semname, int index)
-:   m_id(0)
+RlSocket::~RlSocket()
 {
-    SG_UNUSED(semname);
-    SG_UNUSED(index);
+    if (m_fd != -1)
+        close(m_fd);
 }
 
-RlSemaphore::~RlSemaphore()
+void RlSocket::Connect(const bfs::path& name, double timeout)
 {
+    sockaddr_un address;
+    MakeAddress(name, address);
+    const int retryusec = 100000;
+    for (double waited = 0; ; waited += retryusec * 1e-6)
+    {
+        m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (m_fd == -1)
+            throw SgException("Failed to create socket");
+        if (connect(m_fd, (sockaddr*) &address, sizeof(address)) == 0)
+        {
+            NoSigPipe(m_fd);
+            return;
+        }
+        close(m_fd);
+        m_fd = -1;
+        if ((errno != ENOENT && errno != ECONNREFUSED) || waited >= timeout)
+            throw SgException("Failed to connect to socket "
+                + name.native_file_string() + ": " + strerror(errno));
+        usleep(retryusec);
+    }
 }
 
-void RlSemaphore::Lock()
+void RlSocket::Send(const void* data, int bytes)
 {
+    const char* p = static_cast<const char*>(data);
+    while (bytes > 0)
+    {
+        // Report a dead peer as EPIPE rather than killing us with SIGPIPE
+        ssize_t sent = send(m_fd, p, bytes, SEND_FLAGS);
+        if (sent == -1 && errno == EINTR)
+            continue;
+        if (sent == -1 && errno == EPIPE)
+            throw SgException("Failed to send to socket: "
+                "connection closed by peer");
+        if (sent <= 0)
+            throw SgException("Failed to send to socket");
+        p += sent;
+        bytes -= sent;
+    }
 }
 
-void RlSemaphore::Unlock()
+void RlSocket::Receive(void* data, int bytes)
+{
+    char* p = static_cast<char*>(data);
+    while (bytes > 0)
+    {
+        ssize_t received = recv(m_fd, p, bytes, 0);
+        if (received == -1 && errno == EINTR)
+            continue;
+        if (received <= 0)
+            throw SgException("Failed to receive from socket");
+        p += received;
+        bytes -= received;
+    }
+}
+
+RlListener::RlListener(const bfs::path& name)
+:   m_name(name)
+{
+    sockaddr_un address;
+    MakeAddress(name, address);
+    unlink(address.sun_path); // remove stale socket
+    m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_fd == -1)
+        throw SgException("Failed to create socket");
+    if (bind(m_fd, (sockaddr*) &address, sizeof(address)) == -1
+        || listen(m_fd, SOMAXCONN) == -1)
+    {
+        close(m_fd);
+        throw SgException("Failed to listen on socket "
+            + name.native_file_string() + ": " + strerror(errno));
+    }
+}
+
+RlListener::~RlListener()
+{
+    close(m_fd);
+    unlink(m_name.native_file_string().c_str());
+}
+
+RlSocket* RlListener::Accept()
 {
+    int fd;
+    do
+        fd = accept(m_fd, 0, 0);
+    while (fd == -1 && errno == EINTR);
+    if (fd == -1)
+        throw SgException("Failed to accept connection on socket");
+    return new RlSocket(fd);
 }
 
-#endif // RL_MULTI
+//----------------------------------------------------------------------------
+
+namespace {
+
+const int TABLE_MAGIC = 0x52544142; // "RTAB"
+
+} // namespace
+
+RlTableHeader::RlTableHeader(int version)
+:   m_magic(TABLE_MAGIC),
+    m_version(version),
+    m_boardSize(0),
+    m_xSize(0),
+    m_ySize(0),
+    m_symmetry(0),
+    m_flags(0),
+    m_numFeatures(0),
+    m_numOutputs(0),
+    m_dataBytes(0),
+    m_checksum(0),
+    m_padding(0)
+{
+}
+
+bool RlTableHeader::Matches(const RlTableHeader& expected) const
+{
+    return m_magic == expected.m_magic
+        && m_version == expected.m_version
+        && m_boardSize == expected.m_boardSize
+        && m_xSize == expected.m_xSize
+        && m_ySize == expected.m_ySize
+        && m_symmetry == expected.m_symmetry
+        && m_flags == expected.m_flags
+        && m_numFeatures == expected.m_numFeatures
+        && (expected.m_numOutputs == 0 
+            || m_numOutputs == expected.m_numOutputs)
+        && (expected.m_dataBytes == 0
+            || m_dataBytes == expected.m_dataBytes);
+}
+
+RlMappedTable::RlMappedTable()
+:   m_base(0),
+    m_size(0)
+{
+}
+
+RlMappedTable::~RlMappedTable()
+{
+    Close();
+}
+
+bool RlMappedTable::Open(const bfs::path& filename, 
+    const RlTableHeader& expected, bool verify)
+{
+    Close();
+
+    std::string name = filename.native_file_string();
+    int fd = open(name.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) == -1 
+        || info.st_size < (off_t) sizeof(RlTableHeader))
+    {
+        close(fd);
+        return false;
+    }
+
+    void* base = mmap(0, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // mapping remains valid
+    if (base == MAP_FAILED)
+        return false;
+    m_base = static_cast<char*>(base);
+    m_size = info.st_size;
+
+    const RlTableHeader& header = GetHeader();
+    if (!header.Matches(expected)
+        || header.m_dataBytes < 0
+        || m_size != sizeof(RlTableHeader) + header.m_dataBytes
+        || (verify 
+            && Checksum(GetData(), header.m_dataBytes) != header.m_checksum))
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void RlMappedTable::Close()
+{
+    if (m_base)
+        munmap(m_base, m_size);
+    m_base = 0;
+    m_size = 0;
+}
+
+bool RlMappedTable::Save(const bfs::path& filename, RlTableHeader header,
+    const BlockList& blocks)
+{
+    header.m_dataBytes = 0;
+    header.m_checksum = Checksum(0, 0);
+    for (BlockList::const_iterator i_block = blocks.begin();
+        i_block != blocks.end(); ++i_block)
+    {
+        header.m_dataBytes += i_block->second;
+        header.m_checksum = Checksum(
+            i_block->first, i_block->second, header.m_checksum);
+    }
+
+    std::string name = filename.native_file_string();
+    ostringstream tmpname;
+    tmpname << name << ".tmp" << getpid();
+    {
+        ofstream table(tmpname.str().c_str(), ios::binary | ios::out);
+        if (!table)
+            return false;
+        table.write((const char*) &header, sizeof(RlTableHeader));
+        for (BlockList::const_iterator i_block = blocks.begin();
+            i_block != blocks.end(); ++i_block)
+            table.write(i_block->first, i_block->second);
+        if (!table)
+        {
+            table.close();
+            remove(tmpname.str().c_str());
+            return false;
+        }
+    }
+
+    // Atomically replace any existing (stale) table
+    if (rename(tmpname.str().c_str(), name.c_str()) == -1)
+    {
+        remove(tmpname.str().c_str());
+        return false;
+    }
+    return true;
+}
+
+unsigned int RlMappedTable::Checksum(const char* data, int bytes,
+    unsigned int checksum)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    for (int i = 0; i < bytes; ++i)
+    {
+        checksum ^= p[i];
+        checksum *= 16777619u;
+    }
+    return checksum;
+}
 
 //----------------------------------------------------------------------------
@@ -8,36 +8,89 @@
 #define RLPROCESSUTIL_H
 
 #include <string>
+#include <utility>
+#include <vector>
 #include <boost/filesystem/path.hpp>
 
 namespace bfs = boost::filesystem;
 
 //----------------------------------------------------------------------------
-/** Shared memory object. */
+/** Shared memory backed by a memory mapped file.
+    All processes that attach to the same file share its data, without
+    any system-wide shared memory limits or key files. The file starts with a 
+    header that records the data size and the number of attached processes. 
+    The first process to attach creates the file with zeroed data, and the 
+    last process to detach removes it. Attaching and detaching are 
+    serialised by a lock on the file. */
 class RlSharedMemory
 {
 public:
 
-    RlSharedMemory(const bfs::path& sharename, int index, int bytes);
+    /** Attach to shared memory, creating it if necessary */
+    RlSharedMemory(const bfs::path& filename, int bytes);
+
+    /** Detach from shared memory */
     ~RlSharedMemory();
     
     char* GetData() { return m_data; }
 
-    void Error(const std::string& funcname);
-    
+    /** Whether this process created the shared memory */
+    bool IsCreator() const { return m_creator; }
+
+    /** Number of processes currently attached */
+    int GetNumAttached() const;
+
 private:
 
-    int m_id;
+    struct Header
+    {
+        int m_magic;
+        int m_bytes;
+        volatile int m_attached;
+        int m_padding;
+    };
+
+    void Error(const std::string& funcname);
+
+    bfs::path m_filename;
+    int m_fd;
+    std::size_t m_size;
+    char* m_base;
     char* m_data;
+    bool m_creator;
+
+    /** Not implemented */
+    RlSharedMemory(const RlSharedMemory&);
+    RlSharedMemory& operator=(const RlSharedMemory&);
 };
 
+/** Atomically add to a value that may be written concurrently by other
+    threads or processes, using compare-and-swap */
+inline void RlAtomicAdd(double& value, double delta)
+{
+    union Bits
+    {
+        double m_value;
+        long long m_bits;
+    };
+    volatile long long* target = reinterpret_cast<volatile long long*>(&value);
+    Bits oldbits, newbits;
+    do
+    {
+        oldbits.m_bits = *target;
+        newbits.m_value = oldbits.m_value + delta;
+    } 
+    while (!__sync_bool_compare_and_swap(target, 
+        oldbits.m_bits, newbits.m_bits));
+}
+
 //----------------------------------------------------------------------------
-/** Semaphore for controlling access between processes */
+/** Lock for controlling access between processes, using a lock file */
 class RlSemaphore
 {
 public:
 
-    RlSemaphore(const bfs::path& semname, int index);
+    RlSemaphore(const bfs::path& lockname);
     ~RlSemaphore();
     
     void Lock();
@@ -45,7 +98,134 @@ public:
 
 private:
 
-    int m_id;
+    int m_fd;
+};
+
+//----------------------------------------------------------------------------
+/** Stream connection between processes over a Unix domain socket.
+    Send and Receive transfer all bytes or throw an exception. */
+class RlSocket
+{
+public:
+
+    RlSocket(int fd = -1);
+    ~RlSocket();
+
+    /** Connect to listening socket, retrying for up to specified time 
+        while the socket doesn't exist yet */
+    void Connect(const bfs::path& name, double timeout);
+
+    void Send(const void* data, int bytes);
+    void Receive(void* data, int bytes);
+
+private:
+
+    int m_fd;
+
+    /** Not implemented */
+    RlSocket(const RlSocket&);
+    RlSocket& operator=(const RlSocket&);
+};
+
+//----------------------------------------------------------------------------
+/** Listening Unix domain socket, removed when destroyed */
+class RlListener
+{
+public:
+
+    RlListener(const bfs::path& name);
+    ~RlListener();
+
+    /** Wait for next connection (caller takes ownership) */
+    RlSocket* Accept();
+
+private:
+
+    bfs::path m_name;
+    int m_fd;
+
+    /** Not implemented */
+    RlListener(const RlListener&);
+    RlListener& operator=(const RlListener&);
+};
+
+//----------------------------------------------------------------------------
+/** Header for precomputed tables that are stored on disk and mapped 
+    read-only into memory. A table file is only used if its header matches
+    the header expected by the caller, so stale tables are rebuilt. */
+struct RlTableHeader
+{
+    RlTableHeader(int version = 0);
+
+    /** Check whether this header describes the expected table.
+        The number of outputs and data size are only compared if they are
+        specified (non-zero) in the expected header. */
+    bool Matches(const RlTableHeader& expected) const;
+
+    int m_magic;
+    int m_version;
+    int m_boardSize;
+    int m_xSize;
+    int m_ySize;
+    int m_symmetry;
+    int m_flags;
+    int m_numFeatures;
+    int m_numOutputs;
+    int m_dataBytes;
+    unsigned int m_checksum;
+    int m_padding;
+};
+
+//----------------------------------------------------------------------------
+/** Read-only memory mapped table file.
+    All processes mapping the same file share one physical copy of the 
+    table through the page cache. */
+class RlMappedTable
+{
+public:
+
+    /** Blocks of data to write after the header */
+    typedef std::vector<std::pair<const char*, int> > BlockList;
+
+    RlMappedTable();
+    ~RlMappedTable();
+
+    /** Map table file. Returns false if the file doesn't exist or doesn't
+        match the expected header. The checksum of the data is only 
+        verified if requested, because it touches every page of the table,
+        so opening is otherwise independent of the table size. */
+    bool Open(const bfs::path& filename, const RlTableHeader& expected,
+        bool verify = false);
+
+    /** Unmap table file */
+    void Close();
+
+    bool IsOpen() const { return m_base != 0; }
+
+    const RlTableHeader& GetHeader() const 
+    { 
+        return *reinterpret_cast<const RlTableHeader*>(m_base); 
+    }
+
+    const char* GetData() const { return m_base + sizeof(RlTableHeader); }
+
+    /** Write table file. The file is written under a temporary name and 
+        then renamed, so that other processes never map a partial table. */
+    static bool Save(const bfs::path& filename, RlTableHeader header,
+        const BlockList& blocks);
+
+    /** FNV-1a checksum, can be chained across blocks */
+    static unsigned int Checksum(const char* data, int bytes,
+        unsigned int checksum = 2166136261u);
+
+private:
+
+    char* m_base;
+    std::size_t m_size;
+
+    /** Not implemented */
+    RlMappedTable(const RlMappedTable&);
+    RlMappedTable& operator=(const RlMappedTable&);
 };
 
 //----------------------------------------------------------------------------
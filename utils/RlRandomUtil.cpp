@@ -0,0 +1,63 @@
+//----------------------------------------------------------------------------
+/** @file RlRandomUtil.cpp
+    See RlRandomUtil.h
+*/
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+#include "RlRandomUtil.h"
+
+#include "SgRandom.h"
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/thread/tss.hpp>
+
+using namespace std;
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+boost::thread_specific_ptr<boost::mt19937> s_generator;
+
+} // namespace
+
+//----------------------------------------------------------------------------
+
+namespace RlRandomUtil
+{
+
+void SetThreadSeed(unsigned int seed)
+{
+    s_generator.reset(new boost::mt19937(seed));
+}
+
+void ClearThreadSeed()
+{
+    s_generator.reset();
+}
+
+int Int(int range)
+{
+    SG_ASSERT(range > 0);
+    boost::mt19937* generator = s_generator.get();
+    if (!generator)
+        return SgRandom::Global().Int(range);
+    return static_cast<int>((*generator)() % static_cast<unsigned>(range));
+}
+
+int Range(int min, int max)
+{
+    return min + Int(max - min);
+}
+
+RlFloat Float(RlFloat min, RlFloat max)
+{
+    boost::mt19937* generator = s_generator.get();
+    if (!generator)
+        return SgRandomFloat(min, max);
+    return min + (max - min) * ((*generator)() / 4294967296.0);
+}
+
+} // namespace RlRandomUtil
+
+//----------------------------------------------------------------------------
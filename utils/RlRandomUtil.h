@@ -0,0 +1,39 @@
+//----------------------------------------------------------------------------
+/** @file RlRandomUtil.h
+    Random numbers that are safe to use from worker threads
+*/
+//----------------------------------------------------------------------------
+
+#ifndef RLRANDOMUTIL_H
+#define RLRANDOMUTIL_H
+
+#include "RlMiscUtil.h"
+
+//----------------------------------------------------------------------------
+/** The global Fuego generator is not thread-safe. Threads that have called 
+    SetThreadSeed use their own generator; all other threads (in particular
+    the main thread) use the global generator, so that results are unchanged
+    and reproducible with SgRandom::SetSeed. */
+namespace RlRandomUtil
+{
+
+/** Give the calling thread its own generator with specified seed */
+void SetThreadSeed(unsigned int seed);
+
+/** Remove the calling thread's generator */
+void ClearThreadSeed();
+
+/** Random integer in [0, range) */
+int Int(int range);
+
+/** Random integer in [min, max) */
+int Range(int min, int max);
+
+/** Random floating point number in [min, max) */
+RlFloat Float(RlFloat min, RlFloat max);
+
+} // namespace RlRandomUtil
+
+//----------------------------------------------------------------------------
+
+#endif // RLRANDOMUTIL_H
@@ -0,0 +1,376 @@
+//----------------------------------------------------------------------------
+/** @file RlSimdUtil.cpp
+    See RlSimdUtil.h
+*/
+//----------------------------------------------------------------------------
+
+#include "SgSystem.h"
+#include "RlSimdUtil.h"
+
+#include "RlMathUtil.h"
+#include <string.h>
+
+#ifdef RL_SIMD_X86
+#include <immintrin.h>
+#endif // RL_SIMD_X86
+
+using namespace std;
+
+//----------------------------------------------------------------------------
+
+namespace {
+
+typedef double (*DotFuncD)(const double*, const int*, const int*, int);
+typedef float (*DotFuncF)(const float*, const int*, const int*, int);
+typedef void (*ExpFunc)(const double*, double*, int);
+
+//----------------------------------------------------------------------------
+// exp(x) = 2^k * 2^(j/256) * exp(r), where x / ln2 = k + j/256 + r / ln2.
+// The fractional powers of two are tabulated, and exp(r) with 
+// 0 <= r < ln2/256 is a degree 4 polynomial (truncation error < 2e-15).
+// Outside [EXP_MIN, EXP_MAX] results overflow or are denormal, so libm
+// is used instead.
+
+const double EXP_MIN = -708.0;
+const double EXP_MAX = +709.0;
+const double EXP_SCALE = 256.0 / 0.69314718055994530942;
+const double EXP_RSCALE = 0.69314718055994530942 / 256.0;
+
+struct ExpTable
+{
+    ExpTable()
+    {
+        for (int j = 0; j < 256; ++j)
+            m_powers[j] = pow(2.0, j / 256.0);
+    }
+
+    double m_powers[256];
+};
+
+const double* GetExpTable()
+{
+    static ExpTable s_table;
+    return s_table.m_powers;
+}
+
+inline double PowerOfTwo(int k)
+{
+    unsigned long long bits = (unsigned long long) (k + 1023) << 52;
+    double result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+inline double ExpPolynomial(double r)
+{
+    return 1.0 + r * (1.0 + r * (0.5 + r * (1.0 / 6.0 + r * (1.0 / 24.0))));
+}
+
+inline double TableExp(const double* table, double x)
+{
+    if (!(x >= EXP_MIN && x <= EXP_MAX))
+        return exp(x);
+    double t = x * EXP_SCALE;
+    double n = floor(t);
+    double r = (t - n) * EXP_RSCALE;
+    int i = (int) n;
+    return table[i & 255] * ExpPolynomial(r) * PowerOfTwo(i >> 8);
+}
+
+void ScalarExp(const double* values, double* results, int n)
+{
+    const double* table = GetExpTable();
+    for (int i = 0; i < n; ++i)
+        results[i] = TableExp(table, values[i]);
+}
+
+void ExactExp(const double* values, double* results, int n)
+{
+    for (int i = 0; i < n; ++i)
+        results[i] = exp(values[i]);
+}
+
+// All gather kernels round each product before adding it (no fused 
+// multiply-add), like the scalar kernel. Vector kernels keep one partial 
+// sum per lane, so results differ from the scalar kernel only by the 
+// order of summation.
+
+template <class T>
+T ScalarDot(const T* weights, const int* indices, 
+    const int* occurrences, int n)
+{
+    T sum = 0;
+    for (int i = 0; i < n; ++i)
+        sum += weights[indices[i]] * occurrences[i];
+    return sum;
+}
+
+#ifdef RL_SIMD_X86
+
+__attribute__((target("avx2")))
+double AVX2Dot(const double* weights, const int* indices, 
+    const int* occurrences, int n)
+{
+    __m256d sum = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i index = _mm_loadu_si128((const __m128i*) (indices + i));
+        __m128i occur = _mm_loadu_si128((const __m128i*) (occurrences + i));
+        __m256d w = _mm256_i32gather_pd(weights, index, 8);
+        sum = _mm256_add_pd(sum, _mm256_mul_pd(w, _mm256_cvtepi32_pd(occur)));
+    }
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(sum), 
+        _mm256_extractf128_pd(sum, 1));
+    double total = _mm_cvtsd_f64(_mm_add_sd(half, 
+        _mm_unpackhi_pd(half, half)));
+    for (; i < n; ++i)
+        total += weights[indices[i]] * occurrences[i];
+    return total;
+}
+
+__attribute__((target("avx2")))
+float AVX2Dot(const float* weights, const int* indices, 
+    const int* occurrences, int n)
+{
+    __m256 sum = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i index = _mm256_loadu_si256((const __m256i*) (indices + i));
+        __m256i occur = _mm256_loadu_si256(
+            (const __m256i*) (occurrences + i));
+        __m256 w = _mm256_i32gather_ps(weights, index, 4);
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(w, _mm256_cvtepi32_ps(occur)));
+    }
+    __m128 quad = _mm_add_ps(_mm256_castps256_ps128(sum), 
+        _mm256_extractf128_ps(sum, 1));
+    quad = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+    quad = _mm_add_ss(quad, _mm_shuffle_ps(quad, quad, 1));
+    float total = _mm_cvtss_f32(quad);
+    for (; i < n; ++i)
+        total += weights[indices[i]] * occurrences[i];
+    return total;
+}
+
+__attribute__((target("avx512f")))
+double AVX512Dot(const double* weights, const int* indices, 
+    const int* occurrences, int n)
+{
+    __m512d sum = _mm512_setzero_pd();
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i index = _mm256_loadu_si256((const __m256i*) (indices + i));
+        __m256i occur = _mm256_loadu_si256(
+            (const __m256i*) (occurrences + i));
+        __m512d w = _mm512_i32gather_pd(index, weights, 8);
+        sum = _mm512_add_pd(sum, 
+            _mm512_mul_pd(w, _mm512_cvtepi32_pd(occur)));
+    }
+    double total = _mm512_reduce_add_pd(sum);
+    for (; i < n; ++i)
+        total += weights[indices[i]] * occurrences[i];
+    return total;
+}
+
+__attribute__((target("avx512f")))
+float AVX512Dot(const float* weights, const int* indices, 
+    const int* occurrences, int n)
+{
+    __m512 sum = _mm512_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m512i index = _mm512_loadu_si512(indices + i);
+        __m512i occur = _mm512_loadu_si512(occurrences + i);
+        __m512 w = _mm512_i32gather_ps(index, weights, 4);
+        sum = _mm512_add_ps(sum, 
+            _mm512_mul_ps(w, _mm512_cvtepi32_ps(occur)));
+    }
+    float total = _mm512_reduce_add_ps(sum);
+    for (; i < n; ++i)
+        total += weights[indices[i]] * occurrences[i];
+    return total;
+}
+
+__attribute__((target("avx2")))
+void AVX2Exp(const double* values, double* results, int n)
+{
+    // Same operations in same order as TableExp, so results are identical
+    const double* table = GetExpTable();
+    const __m256d scale = _mm256_set1_pd(EXP_SCALE);
+    const __m256d rscale = _mm256_set1_pd(EXP_RSCALE);
+    const __m256d minx = _mm256_set1_pd(EXP_MIN);
+    const __m256d maxx = _mm256_set1_pd(EXP_MAX);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d c2 = _mm256_set1_pd(0.5);
+    const __m256d c3 = _mm256_set1_pd(1.0 / 6.0);
+    const __m256d c4 = _mm256_set1_pd(1.0 / 24.0);
+    const __m128i mask = _mm_set1_epi32(255);
+    const __m128i bias = _mm_set1_epi32(1023);
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d x = _mm256_loadu_pd(values + i);
+        __m256d inrange = _mm256_and_pd(_mm256_cmp_pd(x, minx, _CMP_GE_OQ),
+            _mm256_cmp_pd(x, maxx, _CMP_LE_OQ));
+        if (_mm256_movemask_pd(inrange) != 0xF)
+        {
+            for (int j = i; j < i + 4; ++j)
+                results[j] = TableExp(table, values[j]);
+            continue;
+        }
+        __m256d t = _mm256_mul_pd(x, scale);
+        __m256d fl = _mm256_floor_pd(t);
+        __m256d r = _mm256_mul_pd(_mm256_sub_pd(t, fl), rscale);
+        __m128i k = _mm256_cvtpd_epi32(fl);
+        __m256d power = _mm256_i32gather_pd(table, 
+            _mm_and_si128(k, mask), 8);
+        __m256d p = _mm256_add_pd(c3, _mm256_mul_pd(r, c4));
+        p = _mm256_add_pd(c2, _mm256_mul_pd(r, p));
+        p = _mm256_add_pd(one, _mm256_mul_pd(r, p));
+        p = _mm256_add_pd(one, _mm256_mul_pd(r, p));
+        __m256i bits = _mm256_slli_epi64(_mm256_cvtepi32_epi64(
+            _mm_add_epi32(_mm_srai_epi32(k, 8), bias)), 52);
+        __m256d result = _mm256_mul_pd(_mm256_mul_pd(power, p), 
+            _mm256_castsi256_pd(bits));
+        _mm256_storeu_pd(results + i, result);
+    }
+    for (; i < n; ++i)
+        results[i] = TableExp(table, values[i]);
+}
+
+#endif // RL_SIMD_X86
+
+int DetectInstructionSet()
+{
+#ifdef RL_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return RlSimdUtil::eAVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return RlSimdUtil::eAVX2;
+#endif // RL_SIMD_X86
+    return RlSimdUtil::eScalar;
+}
+
+/** Currently selected kernels */
+struct Kernels
+{
+    Kernels()
+    :   m_exact(false)
+    {
+        GetExpTable(); // build table before any threads are started
+        Select(DetectInstructionSet());
+    }
+
+    void Select(int set)
+    {
+        m_set = set;
+        m_dotD = ScalarDot<double>;
+        m_dotF = ScalarDot<float>;
+        m_exp = ScalarExp;
+#ifdef RL_SIMD_X86
+        if (set == RlSimdUtil::eAVX512)
+        {
+            m_dotD = AVX512Dot;
+            m_dotF = AVX512Dot;
+            m_exp = AVX2Exp;
+        }
+        else if (set == RlSimdUtil::eAVX2)
+        {
+            m_dotD = AVX2Dot;
+            m_dotF = AVX2Dot;
+            m_exp = AVX2Exp;
+        }
+#endif // RL_SIMD_X86
+        if (m_exact)
+            m_exp = ExactExp;
+    }
+
+    int m_set;
+    bool m_exact;
+    DotFuncD m_dotD;
+    DotFuncF m_dotF;
+    ExpFunc m_exp;
+};
+
+Kernels& GetKernels()
+{
+    static Kernels s_kernels;
+    return s_kernels;
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
+
+namespace RlSimdUtil
+{
+
+int GetInstructionSet()
+{
+    return GetKernels().m_set;
+}
+
+void SetInstructionSet(int set)
+{
+    int best = DetectInstructionSet();
+    GetKernels().Select(set <= best ? set : best);
+}
+
+double GatherDot(const double* weights, const int* indices, 
+    const int* occurrences, int n)
+{
+    return GetKernels().m_dotD(weights, indices, occurrences, n);
+}
+
+float GatherDot(const float* weights, const int* indices, 
+    const int* occurrences, int n)
+{
+    return GetKernels().m_dotF(weights, indices, occurrences, n);
+}
+
+void Exp(const double* values, double* results, int n)
+{
+    GetKernels().m_exp(values, results, n);
+}
+
+void Logistic(const double* values, double* results, int n)
+{
+    // Same expression as RlMathUtil::Logistic
+    for (int i = 0; i < n; ++i)
+        results[i] = -values[i];
+    GetKernels().m_exp(results, results, n);
+    for (int i = 0; i < n; ++i)
+        results[i] = 1.0 / (1.0 + results[i]);
+}
+
+double Exp(double value)
+{
+    if (GetKernels().m_exact)
+        return exp(value);
+    return TableExp(GetExpTable(), value);
+}
+
+double Logistic(double value)
+{
+    return 1.0 / (1.0 + Exp(-value));
+}
+
+void SetExactMath(bool exact)
+{
+    Kernels& kernels = GetKernels();
+    kernels.m_exact = exact;
+    kernels.Select(kernels.m_set);
+}
+
+bool GetExactMath()
+{
+    return GetKernels().m_exact;
+}
+
+}
+
+//----------------------------------------------------------------------------
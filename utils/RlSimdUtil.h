@@ -0,0 +1,103 @@
+//----------------------------------------------------------------------------
+/** @file RlSimdUtil.h
+    Vectorized kernels for sparse dot products and transcendental functions
+*/
+//----------------------------------------------------------------------------
+
+#ifndef RLSIMDUTIL_H
+#define RLSIMDUTIL_H
+
+//----------------------------------------------------------------------------
+
+/** Define this to disable SIMD kernels, even if supported by the compiler */
+//#define RL_NO_SIMD
+
+#if !defined(RL_NO_SIMD) && defined(__GNUC__) \
+    && (defined(__x86_64__) || defined(__i386__))
+#define RL_SIMD_X86
+#endif
+
+/** Define this to disable software prefetching ahead of table lookups 
+    (e.g. to measure its benefit) */
+//#define RL_NO_PREFETCH
+
+#if !defined(RL_NO_PREFETCH) && defined(__GNUC__)
+#define RL_PREFETCH
+#endif
+
+namespace RlSimdUtil
+{
+
+/** Instruction sets for gather kernels */
+enum
+{
+    eScalar,
+    eAVX2,
+    eAVX512
+};
+
+/** Best instruction set supported by this processor 
+    (detected once, at runtime) */
+int GetInstructionSet();
+
+/** Force a particular instruction set, e.g. eScalar for reference results.
+    Falls back to the best supported set if requested set is unavailable. */
+void SetInstructionSet(int set);
+
+/** Sparse dot product: sum of weights[indices[i]] * occurrences[i].
+    Vector kernels sum in a different order from the scalar kernel, so
+    results may differ between instruction sets by rounding error. */
+double GatherDot(const double* weights, const int* indices, 
+    const int* occurrences, int n);
+float GatherDot(const float* weights, const int* indices, 
+    const int* occurrences, int n);
+
+/** Scalar version, for non-integer occurrences */
+template <class T, class OCCUR>
+inline T GatherDot(const T* weights, const int* indices, 
+    const OCCUR* occurrences, int n)
+{
+    T sum = 0;
+    for (int i = 0; i < n; ++i)
+        sum += weights[indices[i]] * occurrences[i];
+    return sum;
+}
+
+/** Prefetch weights[indices[i]] for all i, so that the cache misses of 
+    a following gather are all in flight at once */
+template <class T>
+inline void GatherPrefetch(const T* weights, const int* indices, int n)
+{
+#ifdef RL_PREFETCH
+    for (int i = 0; i < n; ++i)
+        __builtin_prefetch(weights + indices[i]);
+#else
+    SG_UNUSED(weights);
+    SG_UNUSED(indices);
+    SG_UNUSED(n);
+#endif
+}
+
+/** Batch exponential, results[i] = exp(values[i]). Results may overwrite
+    values. Uses a 256 entry table of powers of two and a short polynomial,
+    with relative error below 1e-12. Scalar and vector kernels give
+    identical results. */
+void Exp(const double* values, double* results, int n);
+
+/** Batch logistic function, results[i] = 1 / (1 + exp(-values[i])) */
+void Logistic(const double* values, double* results, int n);
+
+/** Scalar versions of the table-driven kernels */
+double Exp(double value);
+double Logistic(double value);
+
+/** Use libm exp instead, giving results that are bit-exact with 
+    RlMathUtil::Logistic and exp (e.g. to reproduce old experiments) */
+void SetExactMath(bool exact);
+bool GetExactMath();
+
+}
+
+//----------------------------------------------------------------------------
+
+#endif // RLSIMDUTIL_H